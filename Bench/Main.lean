@@ -0,0 +1,144 @@
+/-
+  Chronos Benchmarks
+  DateTime arithmetic: the single-normalization engine against the
+  previous chained implementation (seconds → minutes → hours → days,
+  each day step a Julian Day round trip), kept here as `Legacy`.
+-/
+
+import Chronos
+
+open Chronos
+
+namespace Legacy
+
+/-- Convert date to Julian Day Number (days since November 24, 4714 BC).
+    Used for efficient date arithmetic. -/
+def toJulianDayNumber (dt : DateTime) : Int :=
+  let y := dt.year.toInt
+  let m := dt.month.toNat
+  let d := dt.day.toNat
+  -- Algorithm from Wikipedia: Julian day
+  let a := (14 - m) / 12
+  let yAdj := y + 4800 - a
+  let mAdj := m + 12 * a - 3
+  d + (153 * mAdj + 2) / 5 + 365 * yAdj + yAdj / 4 - yAdj / 100 + yAdj / 400 - 32045
+
+/-- Convert Julian Day Number back to date components.
+    Time components are preserved from the original DateTime. -/
+def fromJulianDayNumber (jdn : Int) (hour minute second : UInt8) (nanosecond : UInt32) : DateTime :=
+  -- Inverse algorithm
+  let a := jdn + 32044
+  let b := (4 * a + 3) / 146097
+  let c := a - 146097 * b / 4
+  let d := (4 * c + 3) / 1461
+  let e := c - 1461 * d / 4
+  let m := (5 * e + 2) / 153
+  let day := e - (153 * m + 2) / 5 + 1
+  let month := m + 3 - 12 * (m / 10)
+  let year := 100 * b + d - 4800 + m / 10
+  { year := Int.toInt32 year, month := UInt8.ofNat month.toNat, day := UInt8.ofNat day.toNat,
+    hour, minute, second, nanosecond }
+
+/-- Add days to a DateTime (pure, no IO). -/
+def addDaysPure (dt : DateTime) (days : Int) : DateTime :=
+  let jdn := toJulianDayNumber dt + days
+  fromJulianDayNumber jdn dt.hour dt.minute dt.second dt.nanosecond
+
+/-- Add hours to a DateTime, with proper day overflow (pure, no IO). -/
+def addHoursPure (dt : DateTime) (hours : Int) : DateTime :=
+  let totalHours : Int := dt.hour.toNat + hours
+  let dayDelta := totalHours / 24
+  let newHourRaw := totalHours % 24
+  let (dayDelta, newHour) :=
+    if newHourRaw < 0 then (dayDelta - 1, newHourRaw + 24)
+    else (dayDelta, newHourRaw)
+  let newDt := addDaysPure dt dayDelta
+  { newDt with hour := UInt8.ofNat newHour.toNat }
+
+/-- Add minutes to a DateTime, with proper hour/day overflow (pure, no IO). -/
+def addMinutesPure (dt : DateTime) (minutes : Int) : DateTime :=
+  let totalMinutes : Int := dt.minute.toNat + minutes
+  let hourDelta := totalMinutes / 60
+  let newMinuteRaw := totalMinutes % 60
+  let (hourDelta, newMinute) :=
+    if newMinuteRaw < 0 then (hourDelta - 1, newMinuteRaw + 60)
+    else (hourDelta, newMinuteRaw)
+  let newDt := addHoursPure dt hourDelta
+  { newDt with minute := UInt8.ofNat newMinute.toNat }
+
+/-- Add seconds to a DateTime, with proper minute/hour/day overflow (pure, no IO). -/
+def addSecondsPure (dt : DateTime) (seconds : Int) : DateTime :=
+  let totalSeconds : Int := dt.second.toNat + seconds
+  let minuteDelta := totalSeconds / 60
+  let newSecondRaw := totalSeconds % 60
+  let (minuteDelta, newSecond) :=
+    if newSecondRaw < 0 then (minuteDelta - 1, newSecondRaw + 60)
+    else (minuteDelta, newSecondRaw)
+  let newDt := addMinutesPure dt minuteDelta
+  { newDt with second := UInt8.ofNat newSecond.toNat }
+
+/-- Add a Duration to a DateTime (pure, no IO). -/
+def addDurationPure (dt : DateTime) (d : Duration) : DateTime :=
+  -- Convert duration to seconds and remaining nanoseconds
+  let totalNanos : Int := dt.nanosecond.toNat + (d.nanoseconds % 1000000000)
+  let secDelta := d.nanoseconds / 1000000000
+  let (secDelta, newNano) :=
+    if totalNanos < 0 then
+      (secDelta - 1, totalNanos + 1000000000)
+    else if totalNanos >= 1000000000 then
+      (secDelta + 1, totalNanos - 1000000000)
+    else
+      (secDelta, totalNanos)
+  let newDt := addSecondsPure dt secDelta
+  { newDt with nanosecond := UInt32.ofNat newNano.toNat }
+
+end Legacy
+
+-- ============================================================================
+-- Harness
+-- ============================================================================
+
+/-- Apply `f` to `n` consecutive offsets and fold the results into a checksum
+    so the work cannot be optimized away. -/
+def run (n : Nat) (f : Int → DateTime) : IO Nat := do
+  let mut acc : Nat := 0
+  for i in [0:n] do
+    let dt := f (i : Int)
+    acc := acc + dt.day.toNat + dt.second.toNat + dt.nanosecond.toNat % 7
+  return acc
+
+def benchPair (label : String) (n : Nat) (legacy current : Int → DateTime) : IO Unit := do
+  -- Results must agree before timings mean anything
+  for i in [0:1000] do
+    let k : Int := i * 197 - 100000
+    if legacy k != current k then
+      throw (IO.userError s!"{label}: mismatch at {k}: {legacy k} vs {current k}")
+  let (a, tLegacy) ← time (run n legacy)
+  let (b, tCurrent) ← time (run n current)
+  if a != b then throw (IO.userError s!"{label}: checksum mismatch")
+  let perLegacy := tLegacy.nanoseconds / n
+  let perCurrent := tCurrent.nanoseconds / n
+  IO.println s!"{label}: legacy {perLegacy} ns/op, current {perCurrent} ns/op"
+
+def main : IO Unit := do
+  let base : DateTime :=
+    { year := 2024, month := 2, day := 28, hour := 23, minute := 59, second := 30, nanosecond := 250000000 }
+  let n := 1000000
+  IO.println s!"DateTime arithmetic, {n} iterations each"
+  benchPair "addSeconds (same day)" n
+    (fun k => Legacy.addSecondsPure base (k % 20)) (fun k => base.addSecondsPure (k % 20))
+  benchPair "addSeconds (crossing days)" n
+    (fun k => Legacy.addSecondsPure base (k * 37)) (fun k => base.addSecondsPure (k * 37))
+  benchPair "addHours" n
+    (fun k => Legacy.addHoursPure base k) (fun k => base.addHoursPure k)
+  benchPair "addDays" n
+    (fun k => Legacy.addDaysPure base k) (fun k => base.addDaysPure k)
+  benchPair "addDuration" n
+    (fun k => Legacy.addDurationPure base (Duration.fromNanoseconds (k * 1234567891)))
+    (fun k => base.addDurationPure (Duration.fromNanoseconds (k * 1234567891)))
+  -- Sorted event stream, ~86 events per day
+  let tss := (Array.range n).map fun i => Timestamp.fromSeconds (1700000000 + (i : Int) * 1000)
+  let (viaFFI, tFFI) ← time (tss.mapM DateTime.fromTimestampUtc)
+  let (viaCache, tCache) ← time (IO.lazyPure fun _ => DateTime.fromTimestampsUtc tss)
+  if viaFFI != viaCache then throw (IO.userError "UtcConverter: results differ from gmtime_r")
+  IO.println s!"fromTimestampUtc (sorted stream): gmtime_r {tFFI.nanoseconds / n} ns/op, UtcConverter {tCache.nanoseconds / n} ns/op"
@@ -43,6 +43,24 @@ import Chronos.Timestamp
 import Chronos.DateTime
 import Chronos.Monotonic
 import Chronos.Timezone
+import Chronos.Bucket
+import Chronos.BusinessCalendar
+import Chronos.Recurrence
+import Chronos.Range
+import Chronos.LeapSecond
+import Chronos.Interval
+import Chronos.TimestampIndex
+import Chronos.LocalDays
+import Chronos.UtcConverter
+import Chronos.WorldClock
+import Chronos.ZonedDateTime
+import Chronos.DstPolicy
+import Chronos.ClockSnapshot
+import Chronos.Segment
+import Chronos.LogSeek
+import Chronos.CsvTimestamps
+import Chronos.Clock
+import Chronos.Resample
 
 namespace Chronos
 
@@ -0,0 +1,158 @@
+/-
+  Chronos.Bucket
+  Bulk time bucketing: calendar truncation (date_trunc) and
+  fixed-width binning (date_bin) over timestamp arrays.
+
+  All bucketing is done in UTC with pure integer arithmetic; no
+  `DateTime` is built per event and libc is never consulted.
+-/
+
+import Chronos.DateTime
+
+namespace Chronos
+
+/-- Calendar units a timestamp can be truncated to. -/
+inductive BucketUnit where
+  | second
+  | minute
+  | hour
+  | day
+  /-- ISO week, starting on Monday. -/
+  | isoWeek
+  | month
+  | quarter
+  | year
+  deriving Repr, BEq, Inhabited, DecidableEq
+
+namespace Bucket
+
+-- ============================================================================
+-- Single-value kernels
+-- ============================================================================
+
+/-- Day number (since 1970-01-01) of the first day of the calendar bucket
+    containing `days`, for the day-or-coarser units. -/
+private def bucketStartDay (unit : BucketUnit) (days : Int) : Int :=
+  match unit with
+  | .isoWeek =>
+    -- 1970-01-01 was a Thursday, i.e. Monday-based index 3
+    days - (days + 3).fmod 7
+  | .month =>
+    let (y, m, _) := DateTime.civilFromDays days
+    DateTime.daysFromCivil y m 1
+  | .quarter =>
+    let (y, m, _) := DateTime.civilFromDays days
+    DateTime.daysFromCivil y ((m - 1) / 3 * 3 + 1) 1
+  | .year =>
+    let (y, _, _) := DateTime.civilFromDays days
+    DateTime.daysFromCivil y 1 1
+  | _ => days
+
+/-- Day number one past the end of the bucket starting at `start`. -/
+private def bucketEndDay (unit : BucketUnit) (start : Int) : Int :=
+  match unit with
+  | .isoWeek => start + 7
+  | .month =>
+    let (y, m, _) := DateTime.civilFromDays start
+    start + (DateTime.daysInMonth (Int.toInt32 y) (UInt8.ofNat m)).toNat
+  | .quarter =>
+    let (y, m, _) := DateTime.civilFromDays start
+    if m ≥ 10 then DateTime.daysFromCivil (y + 1) 1 1
+    else DateTime.daysFromCivil y (m + 3) 1
+  | .year =>
+    let (y, _, _) := DateTime.civilFromDays start
+    DateTime.daysFromCivil (y + 1) 1 1
+  | _ => start + 1
+
+/-- Truncate a timestamp to the start of its UTC bucket (date_trunc).
+    Month, quarter and year buckets follow the Gregorian calendar. -/
+def truncate (unit : BucketUnit) (ts : Timestamp) : Timestamp :=
+  let s := ts.seconds
+  match unit with
+  | .second => Timestamp.fromSeconds s
+  | .minute => Timestamp.fromSeconds (s - s.fmod 60)
+  | .hour => Timestamp.fromSeconds (s - s.fmod 3600)
+  | .day => Timestamp.fromSeconds (s - s.fmod 86400)
+  | _ => Timestamp.fromSeconds (bucketStartDay unit (s.fdiv 86400) * 86400)
+
+/-- Assign a timestamp to a fixed-width bin aligned on `origin` (date_bin).
+    Returns the start of the bin. Non-positive widths return `ts` unchanged. -/
+def bin (width : Duration) (origin : Timestamp) (ts : Timestamp) : Timestamp :=
+  let w := width.nanoseconds
+  if w ≤ 0 then ts
+  else if w % 1000000000 == 0 && origin.nanoseconds == 0 then
+    -- Whole-second widths stay in small-integer seconds arithmetic
+    let ws := w / 1000000000
+    let k := (ts.seconds - origin.seconds).fdiv ws
+    Timestamp.fromSeconds (origin.seconds + k * ws)
+  else
+    let k := (ts.toNanoseconds - origin.toNanoseconds).fdiv w
+    Timestamp.fromNanoseconds (origin.toNanoseconds + k * w)
+
+-- ============================================================================
+-- Bulk kernels
+-- ============================================================================
+
+/-- Truncate every timestamp in an array (date_trunc over a column).
+    Calendar buckets remember the last bucket's day range, so runs of
+    events in the same week/month/quarter/year skip the calendar decode. -/
+def truncateAll (unit : BucketUnit) (tss : Array Timestamp) : Array Timestamp := Id.run do
+  let mut out : Array Timestamp := Array.mkEmpty tss.size
+  match unit with
+  | .second | .minute | .hour | .day =>
+    for ts in tss do
+      out := out.push (truncate unit ts)
+  | _ =>
+    -- Cached bucket as a half-open day range [lo, hi)
+    let mut lo : Int := 1
+    let mut hi : Int := 0
+    for ts in tss do
+      let days := ts.seconds.fdiv 86400
+      if !(lo ≤ days && days < hi) then
+        lo := bucketStartDay unit days
+        hi := bucketEndDay unit lo
+      out := out.push (Timestamp.fromSeconds (lo * 86400))
+  return out
+
+/-- Bin every timestamp in an array to fixed-width buckets (date_bin over a column). -/
+def binAll (width : Duration) (origin : Timestamp) (tss : Array Timestamp) : Array Timestamp :=
+  tss.map (bin width origin)
+
+/-- Truncate every timestamp and return (bucket start, count) pairs for each
+    run of consecutive timestamps in the same bucket. For sorted input this
+    is a one-pass rollup of event counts. -/
+def countRuns (unit : BucketUnit) (tss : Array Timestamp) : Array (Timestamp × Nat) := Id.run do
+  let mut out : Array (Timestamp × Nat) := #[]
+  for b in truncateAll unit tss do
+    match out.back? with
+    | some (last, n) =>
+      if last == b then out := out.pop.push (last, n + 1)
+      else out := out.push (b, 1)
+    | none => out := out.push (b, 1)
+  return out
+
+end Bucket
+
+namespace DateTime
+
+/-- Truncate a DateTime's wall-clock fields to the start of the given unit.
+    Works on the fields as-is, so it applies equally to local and UTC values. -/
+def truncate (dt : DateTime) (unit : BucketUnit) : DateTime :=
+  match unit with
+  | .second => { dt with nanosecond := 0 }
+  | .minute => { dt with second := 0, nanosecond := 0 }
+  | .hour => { dt with minute := 0, second := 0, nanosecond := 0 }
+  | .day => { dt with hour := 0, minute := 0, second := 0, nanosecond := 0 }
+  | .isoWeek =>
+    let days := dt.toEpochDays
+    fromEpochDays (days - (days + 3).fmod 7)
+  | .month => { year := dt.year, month := dt.month, day := 1,
+                hour := 0, minute := 0, second := 0, nanosecond := 0 }
+  | .quarter => { year := dt.year, month := (dt.month - 1) / 3 * 3 + 1, day := 1,
+                  hour := 0, minute := 0, second := 0, nanosecond := 0 }
+  | .year => { year := dt.year, month := 1, day := 1,
+               hour := 0, minute := 0, second := 0, nanosecond := 0 }
+
+end DateTime
+
+end Chronos
@@ -0,0 +1,249 @@
+/-
+  Chronos.BusinessCalendar
+  Business-day calendars with weekend masks and holiday sets.
+
+  A calendar precomputes a span of years into a day bitmap, a per-day
+  rank table (business days before each day) and the ordered list of
+  business days. Within that span "is business day", "add N business
+  days" and "business days between" are O(1) table lookups. Outside it,
+  days are counted arithmetically (whole weeks times the business days
+  per week, plus the partial week) less a binary-searched count of
+  holidays, and "add N" bisects on that count. Weekdays are computed
+  arithmetically, so nothing here touches libc.
+-/
+
+import Chronos.DateTime
+import Std.Data.HashSet
+
+namespace Chronos
+
+open DateTime (Weekday)
+
+/-- Set of weekend days, as a bitmask over `Weekday.toNat` (bit 0 = Sunday). -/
+structure WeekendMask where
+  bits : UInt8
+  deriving Repr, BEq, Inhabited, DecidableEq
+
+namespace WeekendMask
+
+/-- Saturday and Sunday. -/
+def saturdaySunday : WeekendMask := ⟨0x41⟩
+
+/-- Friday and Saturday. -/
+def fridaySaturday : WeekendMask := ⟨0x60⟩
+
+/-- Sunday only. -/
+def sundayOnly : WeekendMask := ⟨0x01⟩
+
+/-- No weekend days. -/
+def empty : WeekendMask := ⟨0⟩
+
+/-- Build a mask from a list of weekend days. -/
+def ofDays (days : List Weekday) : WeekendMask :=
+  ⟨days.foldl (fun acc w => acc ||| ((1 : UInt8) <<< w.toNat.toUInt8)) 0⟩
+
+/-- Check a weekday by its numeric value (0 = Sunday). -/
+def containsIndex (m : WeekendMask) (i : Nat) : Bool :=
+  ((m.bits >>> i.toUInt8) &&& 1) == 1
+
+/-- Check whether a weekday is part of the weekend. -/
+def contains (m : WeekendMask) (w : Weekday) : Bool :=
+  m.containsIndex w.toNat
+
+/-- Number of business days (non-weekend days) in a week. -/
+def businessDaysPerWeek (m : WeekendMask) : Nat :=
+  (List.range 7).countP (!m.containsIndex ·)
+
+end WeekendMask
+
+/-- A business-day calendar: a weekend mask, a holiday set, and precomputed
+    lookup tables over a span of whole years. -/
+structure BusinessCalendar where
+  /-- Days of the week that are never business days. -/
+  weekend : WeekendMask
+  /-- Holidays as days since 1970-01-01. -/
+  holidays : Std.HashSet Int
+  /-- Holidays that fall on non-weekend days, sorted and deduplicated. -/
+  weekdayHolidays : Array Int
+  /-- Day number (since 1970-01-01) of January 1 of the first precomputed year. -/
+  spanStart : Int
+  /-- Number of precomputed days. -/
+  spanDays : Nat
+  /-- One bit per precomputed day, set for business days. -/
+  bitmap : ByteArray
+  /-- `rankBefore[i]` = business days in `[spanStart, spanStart + i)`.
+      Has `spanDays + 1` entries so span-end boundaries resolve too. -/
+  rankBefore : Array UInt32
+  /-- Offsets (from `spanStart`) of every business day in the span, in order. -/
+  businessDays : Array UInt32
+
+namespace BusinessCalendar
+
+-- ============================================================================
+-- Construction
+-- ============================================================================
+
+/-- Build a calendar with tables precomputed for years `fromYear` through
+    `toYear` inclusive. Holiday time-of-day fields are ignored. -/
+def build (fromYear toYear : Int) (weekend : WeekendMask := .saturdaySunday)
+    (holidays : Array DateTime := #[]) : BusinessCalendar := Id.run do
+  let holidaySet := holidays.foldl (fun s h => s.insert h.toEpochDays) ({} : Std.HashSet Int)
+  let spanStart := DateTime.daysFromCivil fromYear 1 1
+  let spanDays := (DateTime.daysFromCivil (toYear + 1) 1 1 - spanStart).toNat
+  let mut bitmap := ByteArray.mk (Array.replicate ((spanDays + 7) / 8) 0)
+  let mut rankBefore : Array UInt32 := Array.mkEmpty (spanDays + 1)
+  let mut businessDays : Array UInt32 := #[]
+  let mut count : UInt32 := 0
+  let mut wd := ((spanStart + 4).fmod 7).toNat
+  for i in [0:spanDays] do
+    rankBefore := rankBefore.push count
+    if !weekend.containsIndex wd && !holidaySet.contains (spanStart + i) then
+      bitmap := bitmap.set! (i / 8) (bitmap.get! (i / 8) ||| ((1 : UInt8) <<< (i % 8).toUInt8))
+      businessDays := businessDays.push i.toUInt32
+      count := count + 1
+    wd := if wd == 6 then 0 else wd + 1
+  rankBefore := rankBefore.push count
+  let weekdayHolidays := (holidaySet.toArray.filter fun d => !weekend.containsIndex ((d + 4).fmod 7).toNat)
+    |>.qsort (· < ·)
+  return { weekend, holidays := holidaySet, weekdayHolidays, spanStart, spanDays, bitmap,
+           rankBefore, businessDays }
+
+-- ============================================================================
+-- Queries on day numbers
+-- ============================================================================
+
+/-- Offset of `day` into the rank table, if it lies within `[spanStart, spanEnd]`. -/
+private def rankIndex? (cal : BusinessCalendar) (day : Int) : Option Nat :=
+  let i := day - cal.spanStart
+  if 0 ≤ i && i ≤ cal.spanDays then some i.toNat else none
+
+/-- Check whether a day (since 1970-01-01) is a business day. -/
+def isBusinessEpochDay (cal : BusinessCalendar) (day : Int) : Bool :=
+  let i := day - cal.spanStart
+  if 0 ≤ i && i < cal.spanDays then
+    let i := i.toNat
+    ((cal.bitmap.get! (i / 8) >>> (i % 8).toUInt8) &&& 1) == 1
+  else
+    !cal.weekend.containsIndex ((day + 4).fmod 7).toNat && !cal.holidays.contains day
+
+/-- Number of entries of a sorted array below `x`. -/
+private def countBelow (xs : Array Int) (x : Int) : Nat := Id.run do
+  let mut lo := 0
+  let mut hi := xs.size
+  while lo < hi do
+    let mid := (lo + hi) / 2
+    if xs[mid]! < x then lo := mid + 1 else hi := mid
+  return lo
+
+/-- Business days in `[a, b)` without the tables: non-weekend days by whole
+    weeks plus the partial week, less the weekday holidays in range. -/
+private def countArith (cal : BusinessCalendar) (a b : Int) : Nat := Id.run do
+  if b ≤ a then return 0
+  let len := (b - a).toNat
+  let mut c := len / 7 * cal.weekend.businessDaysPerWeek
+  -- The partial week starts on the same weekday as `a`
+  let mut wd := ((a + 4).fmod 7).toNat
+  for _ in [0:len % 7] do
+    if !cal.weekend.containsIndex wd then c := c + 1
+    wd := if wd == 6 then 0 else wd + 1
+  return c - (countBelow cal.weekdayHolidays b - countBelow cal.weekdayHolidays a)
+
+/-- Business days in `[lo, hi)` for `lo ≤ hi`: the rank table for the part
+    inside the span, arithmetic for the parts before and after it. -/
+private def countRange (cal : BusinessCalendar) (lo hi : Int) : Nat :=
+  let spanEnd := cal.spanStart + cal.spanDays
+  let inLo := max lo cal.spanStart
+  let inHi := min hi spanEnd
+  let inside :=
+    if inLo < inHi then
+      (cal.rankBefore[(inHi - cal.spanStart).toNat]! - cal.rankBefore[(inLo - cal.spanStart).toNat]!).toNat
+    else 0
+  cal.countArith lo (min hi cal.spanStart) + inside + cal.countArith (max lo spanEnd) hi
+
+/-- `addBusinessEpochDays` when the target leaves the span: bisect for the
+    day at which `countRange` reaches `|n|`. Every 7 days hold a business
+    day unless a weekday holiday takes it, so the target lies within
+    `(|n| + holidays + 1) * 7` days; `none` if the weekend covers the
+    whole week. -/
+private def search (cal : BusinessCalendar) (day : Int) (n : Int) : Option Int := Id.run do
+  if cal.weekend.businessDaysPerWeek == 0 then return none
+  let k := n.natAbs
+  let reach : Int := ((k + cal.weekdayHolidays.size + 1) * 7 : Nat)
+  if n > 0 then
+    -- Smallest x with k business days in [day + 1, x + 1)
+    let mut lo := day + 1
+    let mut hi := day + reach
+    while lo < hi do
+      let mid := (lo + hi).fdiv 2
+      if cal.countRange (day + 1) (mid + 1) ≥ k then hi := mid else lo := mid + 1
+    return some lo
+  else
+    -- Largest x with k business days in [x, day)
+    let mut lo := day - reach
+    let mut hi := day - 1
+    while lo < hi do
+      let mid := (lo + hi + 1).fdiv 2
+      if cal.countRange mid day ≥ k then lo := mid else hi := mid - 1
+    return some lo
+
+/-- The `n`-th business day strictly after `day` (strictly before when `n < 0`).
+    `n = 0` returns `day` unchanged; `none` if the calendar has no business
+    days to count (e.g. a weekend mask covering the whole week). -/
+def addBusinessEpochDays (cal : BusinessCalendar) (day : Int) (n : Int) : Option Int :=
+  if n == 0 then some day
+  else match cal.rankIndex? day with
+    | some i =>
+      let r : Int := (cal.rankBefore[i]!).toNat
+      -- Ordinal of the target business day within the span
+      let target :=
+        if n > 0 then r + (if cal.isBusinessEpochDay day then 1 else 0) + n - 1
+        else r + n
+      if 0 ≤ target && target < cal.businessDays.size then
+        some (cal.spanStart + (cal.businessDays[target.toNat]!).toNat)
+      else cal.search day n
+    | none => cal.search day n
+
+/-- Number of business days in `[a, b)`; negative when `b < a`. -/
+def businessDaysBetweenEpochDays (cal : BusinessCalendar) (a b : Int) : Int :=
+  let (lo, hi, sign) := if a ≤ b then (a, b, (1 : Int)) else (b, a, (-1 : Int))
+  sign * cal.countRange lo hi
+
+-- ============================================================================
+-- DateTime API
+-- ============================================================================
+
+/-- Check whether a date is a business day. Time-of-day fields are ignored. -/
+def isBusinessDay (cal : BusinessCalendar) (dt : DateTime) : Bool :=
+  cal.isBusinessEpochDay dt.toEpochDays
+
+/-- Add `n` business days to a date, preserving its time of day.
+    The result is the `n`-th business day strictly after `dt` (before, for
+    negative `n`); `n = 0` returns `dt` unchanged. `none` if the calendar
+    has no business days. -/
+def addBusinessDays (cal : BusinessCalendar) (dt : DateTime) (n : Int) : Option DateTime :=
+  (cal.addBusinessEpochDays dt.toEpochDays n).map fun day =>
+    DateTime.fromEpochDays day dt.hour dt.minute dt.second dt.nanosecond
+
+/-- Number of business days in `[a, b)` by date; negative when `b` precedes `a`. -/
+def businessDaysBetween (cal : BusinessCalendar) (a b : DateTime) : Int :=
+  cal.businessDaysBetweenEpochDays a.toEpochDays b.toEpochDays
+
+-- ============================================================================
+-- Bulk variants
+-- ============================================================================
+
+/-- `isBusinessDay` over an array of dates. -/
+def isBusinessDayAll (cal : BusinessCalendar) (dts : Array DateTime) : Array Bool :=
+  dts.map cal.isBusinessDay
+
+/-- `addBusinessDays` with the same offset over an array of dates. -/
+def addBusinessDaysAll (cal : BusinessCalendar) (dts : Array DateTime) (n : Int) : Array (Option DateTime) :=
+  dts.map (cal.addBusinessDays · n)
+
+/-- `businessDaysBetween` over an array of (start, end) pairs. -/
+def businessDaysBetweenAll (cal : BusinessCalendar) (ranges : Array (DateTime × DateTime)) : Array Int :=
+  ranges.map fun (a, b) => cal.businessDaysBetween a b
+
+end BusinessCalendar
+
+end Chronos
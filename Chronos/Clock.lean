@@ -0,0 +1,186 @@
+/-
+  Chronos.Clock
+  Pluggable clocks for sleeping, deadlines and scheduling.
+
+  Code that waits takes any `Clock`: the real realtime and monotonic
+  clocks in production, or a `VirtualClock` in tests, whose time only
+  moves when it is advanced. The generic functions are specialized per
+  clock type, so the real clocks compile down to direct calls.
+-/
+
+import Chronos.Timestamp
+import Chronos.Monotonic
+import Chronos.Recurrence
+
+namespace Chronos
+
+/-- A source of time that can also be waited on. Timestamps from a clock
+    are only compared with timestamps from the same clock. -/
+class Clock (κ : Type) where
+  /-- Current time of the clock. -/
+  now : κ → IO Timestamp
+  /-- Wait until the clock reads at least `t`. -/
+  sleepUntil : κ → Timestamp → IO Unit
+
+/-- The system wall clock (CLOCK_REALTIME). -/
+structure RealtimeClock where
+  deriving Inhabited
+
+/-- The system monotonic clock. Its timestamps count from an unspecified
+    origin (typically boot), so only their differences are meaningful. -/
+structure MonotonicClock where
+  deriving Inhabited
+
+@[inline] private def monotonicNow : IO Timestamp := do
+  let m ← MonotonicTime.now
+  return { seconds := m.seconds, nanoseconds := m.nanoseconds }
+
+/-- Real sleeps in whole milliseconds (rounded up) until `now` reaches
+    `t`. Early wakes, e.g. after the wall clock is stepped, sleep again. -/
+@[inline] private def sleepUntilReal (now : IO Timestamp) (t : Timestamp) : IO Unit := do
+  repeat
+    let n ← now
+    if t ≤ n then break
+    let ms := ((t.duration n).nanoseconds + 999999) / 1000000
+    IO.sleep (min ms.toNat 0xFFFFFFFF).toUInt32
+
+instance : Clock RealtimeClock where
+  now _ := Timestamp.now
+  sleepUntil _ := sleepUntilReal Timestamp.now
+
+instance : Clock MonotonicClock where
+  now _ := monotonicNow
+  sleepUntil _ := sleepUntilReal monotonicNow
+
+-- ============================================================================
+-- Virtual clock
+-- ============================================================================
+
+/-- A clock whose time is set by the program. With `autoAdvance`, a
+    sleep moves the clock forward by the requested amount and returns at
+    once, which suits single-threaded code under test. Without it, a
+    sleep blocks until another thread advances the clock far enough. -/
+structure VirtualClock where
+  private mk ::
+  time : IO.Ref Timestamp
+  autoAdvance : Bool
+
+namespace VirtualClock
+
+/-- A virtual clock reading `start`. -/
+def new (start : Timestamp := Timestamp.epoch) (autoAdvance : Bool := true) : IO VirtualClock := do
+  return { time := (← IO.mkRef start), autoAdvance }
+
+/-- Current virtual time. -/
+def read (c : VirtualClock) : IO Timestamp := c.time.get
+
+/-- Move the clock to `t`; earlier times are ignored, so it never runs
+    backwards. -/
+def advanceTo (c : VirtualClock) (t : Timestamp) : IO Unit :=
+  c.time.modify fun now => if now < t then t else now
+
+/-- Move the clock forward by `d`. -/
+def advance (c : VirtualClock) (d : Duration) : IO Unit :=
+  c.time.modify (· + d)
+
+/-- Real time between checks while blocked in `sleep`. -/
+private def pollMillis : UInt32 := 1
+
+private def sleepUntilVirtual (c : VirtualClock) (t : Timestamp) : IO Unit := do
+  if c.autoAdvance then c.advanceTo t
+  else
+    while (← c.read) < t do
+      IO.sleep pollMillis
+
+instance : Clock VirtualClock where
+  now := read
+  sleepUntil := sleepUntilVirtual
+
+end VirtualClock
+
+-- ============================================================================
+-- Waiting
+-- ============================================================================
+
+namespace Clock
+
+variable {κ : Type} [Clock κ]
+
+/-- Wait until `d` of the clock's time has passed. -/
+@[specialize] def sleep (c : κ) (d : Duration) : IO Unit := do
+  Clock.sleepUntil c ((← Clock.now c) + d)
+
+/-- Clock time since `start`. -/
+@[specialize] def elapsed (c : κ) (start : Timestamp) : IO Duration := do
+  return (← Clock.now c).duration start
+
+/-- Run `check` every `interval` until it returns true or `timeout` has
+    passed on the clock. Returns whether `check` succeeded in time. -/
+@[specialize] def pollUntil (c : κ) (timeout interval : Duration) (check : IO Bool) : IO Bool := do
+  let deadline := (← Clock.now c) + timeout
+  repeat
+    if (← check) then return true
+    let now ← Clock.now c
+    if deadline ≤ now then return false
+    let wait := deadline.duration now
+    sleep c (if interval < wait then interval else wait)
+  return false
+
+/-- A point on a clock's timeline after which an operation gives up. -/
+structure Deadline where
+  expiresAt : Timestamp
+  deriving Repr, BEq, Inhabited
+
+/-- A deadline `d` from now. -/
+@[specialize] def deadline (c : κ) (d : Duration) : IO Deadline := do
+  return { expiresAt := (← Clock.now c) + d }
+
+/-- Time left before `dl` (zero once it has passed). -/
+@[specialize] def remaining (c : κ) (dl : Deadline) : IO Duration := do
+  let now ← Clock.now c
+  return if now < dl.expiresAt then dl.expiresAt.duration now else Duration.zero
+
+/-- Whether `dl` has passed. -/
+@[specialize] def expired (c : κ) (dl : Deadline) : IO Bool := do
+  return dl.expiresAt ≤ (← Clock.now c)
+
+-- ============================================================================
+-- Timers and scheduling
+-- ============================================================================
+
+/-- Call `f k t` for `count` ticks at `start + k * interval`, where
+    `start` is the current time. Ticks are scheduled from the start, not
+    from the previous tick, so the rate does not drift; a tick that is
+    already late runs immediately. -/
+@[specialize] def every (c : κ) (interval : Duration) (count : Nat)
+    (f : Nat → Timestamp → IO Unit) : IO Unit := do
+  let start ← Clock.now c
+  for k in [0:count] do
+    let t := start + interval * k
+    Clock.sleepUntil c t
+    f k t
+
+/-- Run `f` at each of `times` (ascending), waiting for each in turn. -/
+@[specialize] def runAt (c : κ) (times : Array Timestamp) (f : Timestamp → IO Unit) : IO Unit := do
+  for t in times do
+    Clock.sleepUntil c t
+    f t
+
+/-- Run `f` at up to `limit` occurrences of a recurrence in `tz`,
+    waiting for each on the clock. Occurrences already in the past run
+    immediately. Returns the iterator positioned after the last run. -/
+@[specialize] def runRecurring (c : κ) (it : RecurrenceIter) (tz : Timezone) (limit : Nat)
+    (f : DateTime → Timestamp → IO Unit) : IO RecurrenceIter := do
+  let mut it := it
+  for _ in [0:limit] do
+    match ← it.nextInstant tz with
+    | some (dt, t, it') =>
+      Clock.sleepUntil c t
+      f dt t
+      it := it'
+    | none => break
+  return it
+
+end Clock
+
+end Chronos
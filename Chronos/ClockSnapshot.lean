@@ -0,0 +1,77 @@
+/-
+  Chronos.ClockSnapshot
+  Mapping monotonic readings to wall-clock timestamps.
+
+  A snapshot pairs one monotonic reading with one wall-clock reading,
+  taken back-to-back (the tightest of several attempts). Monotonic values
+  recorded afterwards convert to timestamps by adding the snapshot's
+  offset, with no clock reads. If the wall clock is stepped (NTP, manual
+  change), the offset no longer holds; `refresh` detects that and takes a
+  new snapshot.
+-/
+
+import Chronos.Timestamp
+import Chronos.Monotonic
+
+namespace Chronos
+
+/-- Paired monotonic and wall-clock readings. -/
+structure ClockSnapshot where
+  /-- Monotonic time at the wall-clock read (midpoint of the bracket). -/
+  monotonic : MonotonicTime
+  /-- Wall-clock time. -/
+  wall : Timestamp
+  /-- Width of the monotonic bracket around the wall read; the pairing
+      error is at most half of this. -/
+  uncertainty : Duration
+  deriving Repr, BEq, Inhabited
+
+namespace ClockSnapshot
+
+/-- Raw FFI: tightest (monotonic, wall, width ns) of `reads` back-to-back reads. -/
+@[extern "chronos_clock_snapshot"]
+private opaque snapshotFFI (reads : UInt32) : IO ((Int × UInt32) × (Int × UInt32) × UInt32)
+
+/-- Read both clocks, keeping the tightest of `reads` attempts. -/
+def take (reads : Nat := 5) : IO ClockSnapshot := do
+  let ((ms, mns), (ws, wns), width) ← snapshotFFI reads.toUInt32
+  return { monotonic := { seconds := ms, nanoseconds := mns },
+           wall := { seconds := ws, nanoseconds := wns },
+           uncertainty := Duration.fromNanoseconds width.toNat }
+
+/-- Wall-clock time of a monotonic reading, assuming the wall clock has not
+    been stepped since the snapshot. Seconds and nanoseconds are carried
+    separately, so no large integers are built. -/
+def toTimestamp (s : ClockSnapshot) (mt : MonotonicTime) : Timestamp :=
+  let ns := mt.nanoseconds.toNat + s.wall.nanoseconds.toNat + 1000000000 - s.monotonic.nanoseconds.toNat
+  { seconds := mt.seconds - s.monotonic.seconds + s.wall.seconds + (ns / 1000000000 : Nat) - 1,
+    nanoseconds := (ns % 1000000000).toUInt32 }
+
+/-- Convert many monotonic readings. -/
+def toTimestamps (s : ClockSnapshot) (mts : Array MonotonicTime) : Array Timestamp :=
+  mts.map s.toTimestamp
+
+/-- How far the wall clock has moved relative to the snapshot's mapping
+    (wall − mapped), measured with a fresh snapshot. Returns the fresh
+    snapshot as well. -/
+def drift (s : ClockSnapshot) (reads : Nat := 5) : IO (Duration × ClockSnapshot) := do
+  let fresh ← take reads
+  return (fresh.wall.duration (s.toTimestamp fresh.monotonic), fresh)
+
+/-- Keep the snapshot while the wall clock agrees with it to within
+    `tolerance` (plus both readings' uncertainty); after a step, return a
+    fresh snapshot instead. -/
+def refresh (s : ClockSnapshot) (tolerance : Duration := Duration.fromMilliseconds 1)
+    (reads : Nat := 5) : IO ClockSnapshot := do
+  let (d, fresh) ← s.drift reads
+  let limit := tolerance.nanoseconds + s.uncertainty.nanoseconds + fresh.uncertainty.nanoseconds
+  return if d.nanoseconds.natAbs ≤ limit.toNat then s else fresh
+
+/-- Whether the wall clock has been stepped since the snapshot. -/
+def stepped (s : ClockSnapshot) (tolerance : Duration := Duration.fromMilliseconds 1) : IO Bool := do
+  let fresh ← s.refresh tolerance
+  return fresh != s
+
+end ClockSnapshot
+
+end Chronos
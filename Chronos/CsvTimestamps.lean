@@ -0,0 +1,323 @@
+/-
+  Chronos.CsvTimestamps
+  Streaming rewrite of timestamp columns in CSV data.
+
+  Input is read in fixed-size chunks and split into records directly in
+  the byte buffer (quoted fields may contain newlines); only a partial
+  last record is carried between chunks, so memory stays bounded by the
+  chunk size plus the longest record.
+  Selected fields are parsed from their bytes (RFC 3339), converted to
+  the target zone through a cached `OffsetSpan` and an incremental
+  `UtcConverter`, and formatted straight into the output buffer. Other
+  fields are copied through untouched.
+-/
+
+import Chronos.DateTime
+import Chronos.Timezone
+import Chronos.Monotonic
+import Chronos.UtcConverter
+
+namespace Chronos
+
+namespace CsvTimestamps
+
+/-- Rendering for rewritten timestamp fields. -/
+inductive Format where
+  /-- `2024-03-10T14:03:05.25-04:00`, with `Z` when no zone is set. -/
+  | rfc3339
+  /-- Whole Unix seconds (the fraction is dropped). -/
+  | epochSeconds
+  /-- Unix milliseconds. -/
+  | epochMillis
+  deriving Repr, BEq, Inhabited
+
+/-- What to rewrite and how. -/
+structure Config where
+  /-- Zero-based indices of the timestamp columns. -/
+  columns : Array Nat
+  /-- Field separator byte. -/
+  delimiter : UInt8 := 44
+  /-- Pass the first line through unchanged. -/
+  hasHeader : Bool := true
+  /-- Zone to render `rfc3339` output in; `none` renders UTC. -/
+  zone : Option Timezone := none
+  format : Format := .rfc3339
+  /-- Bytes requested per read. -/
+  chunkSize : Nat := 65536
+
+/-- Counters and timing for one run. -/
+structure Stats where
+  /-- Data rows (the header is not counted). -/
+  rows : Nat := 0
+  /-- Fields rewritten. -/
+  converted : Nat := 0
+  /-- Fields in timestamp columns that did not parse (copied unchanged). -/
+  failed : Nat := 0
+  bytesIn : Nat := 0
+  bytesOut : Nat := 0
+  elapsed : Duration := Duration.zero
+  deriving Repr, Inhabited
+
+namespace Stats
+
+/-- Data rows per second of elapsed time. -/
+def rowsPerSecond (s : Stats) : Float :=
+  if s.elapsed.isPositive then s.rows.toFloat / s.elapsed.toFloat else 0
+
+/-- Input megabytes (10⁶ bytes) per second of elapsed time. -/
+def megabytesPerSecond (s : Stats) : Float :=
+  if s.elapsed.isPositive then s.bytesIn.toFloat / 1e6 / s.elapsed.toFloat else 0
+
+end Stats
+
+-- ============================================================================
+-- Parsing
+-- ============================================================================
+
+@[inline] private def isDigit (c : UInt8) : Bool := 48 ≤ c && c ≤ 57
+
+/-- `n` decimal digits starting at `i`, all before `e`. -/
+private def digits (b : ByteArray) (e i n : Nat) : Option Nat := do
+  guard (i + n ≤ e)
+  let mut v := 0
+  for k in [0:n] do
+    let c := b[i + k]!
+    guard (isDigit c)
+    v := v * 10 + (c - 48).toNat
+  return v
+
+/-- Parse an RFC 3339 timestamp from `b[start, stop)`: `YYYY-MM-DD`,
+    `T` or a space, `HH:MM:SS`, an optional fraction of at least one
+    digit, and an optional `Z` or `±HH:MM` / `±HHMM` offset (none means
+    UTC). Surrounding spaces and double quotes are ignored. -/
+def parseRfc3339 (b : ByteArray) (start stop : Nat) : Option Timestamp := do
+  let mut s := start
+  let mut e := min stop b.size
+  while s < e && (b[s]! == 32 || b[s]! == 34) do s := s + 1
+  while s < e && (b[e - 1]! == 32 || b[e - 1]! == 34) do e := e - 1
+  guard (e - s ≥ 19)
+  let year ← digits b e s 4
+  let month ← digits b e (s + 5) 2
+  let day ← digits b e (s + 8) 2
+  let hour ← digits b e (s + 11) 2
+  let minute ← digits b e (s + 14) 2
+  let second ← digits b e (s + 17) 2
+  let sep := b[s + 10]!
+  guard (b[s + 4]! == 45 && b[s + 7]! == 45 && b[s + 13]! == 58 && b[s + 16]! == 58)
+  guard (sep == 84 || sep == 116 || sep == 32)
+  guard (1 ≤ month && month ≤ 12 && 1 ≤ day && hour ≤ 23 && minute ≤ 59 && second ≤ 59)
+  guard (day ≤ (DateTime.daysInMonth (Int.toInt32 year) month.toUInt8).toNat)
+  let mut i := s + 19
+  let mut nanos := 0
+  if i < e && (b[i]! == 46 || b[i]! == 44) then
+    i := i + 1
+    guard (i < e && isDigit b[i]!)
+    let mut scale := 100000000
+    while i < e && isDigit b[i]! do
+      nanos := nanos + (b[i]! - 48).toNat * scale
+      scale := scale / 10
+      i := i + 1
+  let mut offset : Int := 0
+  if i < e then
+    let c := b[i]!
+    if c == 90 || c == 122 then
+      i := i + 1
+    else
+      guard (c == 43 || c == 45)
+      let oh ← digits b e (i + 1) 2
+      let j := if i + 3 < e && b[i + 3]! == 58 then i + 4 else i + 3
+      let om ← digits b e j 2
+      guard (oh ≤ 23 && om ≤ 59)
+      offset := ((oh * 3600 + om * 60 : Nat) : Int)
+      if c == 45 then offset := -offset
+      i := j + 2
+  guard (i == e)
+  let sod : Nat := hour * 3600 + minute * 60 + second
+  return { seconds := DateTime.daysFromCivil year month day * 86400 + sod - offset,
+           nanoseconds := nanos.toUInt32 }
+
+-- ============================================================================
+-- Formatting
+-- ============================================================================
+
+/-- Append `v` as exactly `width` decimal digits. -/
+private def pushDigits (out : ByteArray) (v width : Nat) : ByteArray := Id.run do
+  let mut out := out
+  let mut div := 10 ^ (width - 1)
+  for _ in [0:width] do
+    out := out.push (v / div % 10 + 48).toUInt8
+    div := div / 10
+  return out
+
+private def pushInt (out : ByteArray) (v : Int) : ByteArray :=
+  out ++ (toString v).toUTF8
+
+/-- Conversion state carried from one field to the next. -/
+private structure Converter where
+  utc : UtcConverter := {}
+  span : Option OffsetSpan := none
+  deriving Inhabited
+
+/-- Offset of the target zone at `ts`. When `cache` is set the span
+    around the previous lookup is reused while `ts` stays inside it. -/
+private def offsetFor (cfg : Config) (cache : Bool) (c : Converter) (ts : Timestamp) :
+    IO (Int32 × Converter) := do
+  match cfg.zone with
+  | none => return (0, c)
+  | some tz =>
+    if cache && c.span.any (·.contains ts) then return (c.span.get!.offset, c)
+    let s ← tz.offsetSpan ts
+    return (s.offset, { c with span := some s })
+
+private def pushRfc3339 (cfg : Config) (cache : Bool) (out : ByteArray) (c : Converter)
+    (ts : Timestamp) : IO (ByteArray × Converter) := do
+  let (off, c) ← offsetFor cfg cache c ts
+  let (dt, utc) := c.utc.convert { ts with seconds := ts.seconds + off.toInt }
+  let y := dt.year.toInt
+  let mut out := if 0 ≤ y && y ≤ 9999 then pushDigits out y.toNat 4 else pushInt out y
+  out := pushDigits (out.push 45) dt.month.toNat 2
+  out := pushDigits (out.push 45) dt.day.toNat 2
+  out := pushDigits (out.push 84) dt.hour.toNat 2
+  out := pushDigits (out.push 58) dt.minute.toNat 2
+  out := pushDigits (out.push 58) dt.second.toNat 2
+  let ns := ts.nanoseconds.toNat
+  if ns != 0 then
+    out := out.push 46
+    if ns % 1000000 == 0 then out := pushDigits out (ns / 1000000) 3
+    else if ns % 1000 == 0 then out := pushDigits out (ns / 1000) 6
+    else out := pushDigits out ns 9
+  if cfg.zone.isNone then
+    out := out.push 90
+  else
+    let a := off.toInt.natAbs
+    out := out.push (if off < 0 then 45 else 43)
+    out := pushDigits out (a / 3600) 2
+    out := pushDigits (out.push 58) (a % 3600 / 60) 2
+    if a % 60 != 0 then out := pushDigits (out.push 58) (a % 60) 2
+  return (out, { c with utc := utc })
+
+private def pushTimestamp (cfg : Config) (cache : Bool) (out : ByteArray) (c : Converter)
+    (ts : Timestamp) : IO (ByteArray × Converter) :=
+  match cfg.format with
+  | .rfc3339 => pushRfc3339 cfg cache out c ts
+  | .epochSeconds => pure (pushInt out ts.seconds, c)
+  | .epochMillis => pure (pushInt out (ts.seconds * 1000 + (ts.nanoseconds / 1000000).toNat), c)
+
+-- ============================================================================
+-- Streaming
+-- ============================================================================
+
+/-- Per-run state threaded through every line. -/
+private structure RunState where
+  conv : Converter := {}
+  stats : Stats := {}
+  /-- Whether the next line is the header. -/
+  atHeader : Bool
+
+/-- Rewrite the record `b[start, stop)` (without its final newline) into
+    `out`. Delimiters and newlines inside double-quoted fields do not
+    split them. -/
+private def transformLine (cfg : Config) (cache : Bool) (b : ByteArray) (start stop : Nat)
+    (out : ByteArray) (st : RunState) : IO (ByteArray × RunState) := do
+  if st.atHeader then
+    return (b.copySlice start out out.size (stop - start), { st with atHeader := false })
+  -- Keep a CR of a CRLF line ending out of the last field
+  let stop' := if stop > start && b[stop - 1]! == 13 then stop - 1 else stop
+  let mut out := out
+  let mut st := st
+  let mut col := 0
+  let mut fieldStart := start
+  let mut inQuotes := false
+  let mut i := start
+  while i ≤ stop' do
+    let c := if i < stop' then b[i]! else cfg.delimiter
+    if c == 34 then inQuotes := !inQuotes
+    if i == stop' || (c == cfg.delimiter && !inQuotes) then
+      if col > 0 then out := out.push cfg.delimiter
+      let parsed := if cfg.columns.contains col then some (parseRfc3339 b fieldStart i) else none
+      match parsed with
+      | some (some ts) =>
+        let (o, conv) ← pushTimestamp cfg cache out st.conv ts
+        out := o
+        st := { st with conv := conv, stats.converted := st.stats.converted + 1 }
+      | some none =>
+        out := b.copySlice fieldStart out out.size (i - fieldStart)
+        st := { st with stats.failed := st.stats.failed + 1 }
+      | none =>
+        out := b.copySlice fieldStart out out.size (i - fieldStart)
+      col := col + 1
+      fieldStart := i + 1
+    i := i + 1
+  out := b.copySlice stop' out out.size (stop - stop')
+  return (out, { st with stats.rows := st.stats.rows + 1 })
+
+/-- Rewrite every complete record of `b`, returning the offset just past
+    the last record's newline (the start of the unfinished tail). A newline
+    inside a quoted field (RFC 4180) does not end the record; `b` must
+    start at a record boundary. -/
+private def transformLines (cfg : Config) (cache : Bool) (b : ByteArray) (out : ByteArray)
+    (st : RunState) : IO (Nat × ByteArray × RunState) := do
+  let mut out := out
+  let mut st := st
+  let mut lineStart := 0
+  let mut inQuotes := false
+  for i in [0:b.size] do
+    let c := b[i]!
+    if c == 34 then inQuotes := !inQuotes
+    if c == 10 && !inQuotes then
+      let (o, s) ← transformLine cfg cache b lineStart i out st
+      out := o.push 10
+      st := s
+      lineStart := i + 1
+  return (lineStart, out, st)
+
+/-- Stream CSV from `input` to `output`, rewriting the configured
+    timestamp columns. Fields that do not parse are copied unchanged and
+    counted in `Stats.failed`. Output is written once per input chunk. -/
+def transform (cfg : Config) (input output : IO.FS.Stream) : IO Stats := do
+  let started ← MonotonicTime.now
+  -- Spans from zone data or fixed offsets have valid bounds; libc zones
+  -- report one unbounded span, so those are looked up per field
+  let mut cache := false
+  if let some tz := cfg.zone then cache := (← tz.source) != .libc
+  let chunkSize := max cfg.chunkSize 1
+  let mut st : RunState := { atHeader := cfg.hasHeader }
+  let mut carry := ByteArray.empty
+  let mut out : ByteArray := ByteArray.mkEmpty (chunkSize + chunkSize / 2)
+  repeat
+    let chunk ← input.read chunkSize.toUSize
+    if chunk.isEmpty then break
+    st := { st with stats.bytesIn := st.stats.bytesIn + chunk.size }
+    let buf := if carry.isEmpty then chunk else carry ++ chunk
+    let (tail, o, s) ← transformLines cfg cache buf out st
+    st := s
+    carry := buf.extract tail buf.size
+    if !o.isEmpty then
+      output.write o
+      st := { st with stats.bytesOut := st.stats.bytesOut + o.size }
+    -- One preallocated buffer per chunk, sized from the last one
+    out := ByteArray.mkEmpty (max o.size chunkSize)
+  if !carry.isEmpty then
+    let (o, s) ← transformLine cfg cache carry 0 carry.size out st
+    st := s
+    output.write o
+    st := { st with stats.bytesOut := st.stats.bytesOut + o.size }
+  output.flush
+  return { st.stats with elapsed := (← started.elapsed) }
+
+/-- Rewrite timestamp columns of the CSV file at `src` into `dst`. -/
+def transformFile (cfg : Config) (src dst : System.FilePath) : IO Stats := do
+  let input ← IO.FS.Handle.mk src .read
+  let output ← IO.FS.Handle.mk dst .write
+  transform cfg (IO.FS.Stream.ofHandle input) (IO.FS.Stream.ofHandle output)
+
+/-- Rewrite timestamp columns of an in-memory CSV document. -/
+def transformString (cfg : Config) (csv : String) : IO (String × Stats) := do
+  let inRef ← IO.mkRef ({ data := csv.toUTF8 } : IO.FS.Stream.Buffer)
+  let outRef ← IO.mkRef ({} : IO.FS.Stream.Buffer)
+  let stats ← transform cfg (IO.FS.Stream.ofBuffer inRef) (IO.FS.Stream.ofBuffer outRef)
+  return (String.fromUTF8! (← outRef.get).data, stats)
+
+end CsvTimestamps
+
+end Chronos
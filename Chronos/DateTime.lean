@@ -21,7 +21,8 @@ structure DateTime where
   hour : UInt8
   /-- Minute of hour [0, 59]. -/
   minute : UInt8
-  /-- Second of minute [0, 59]. Note: leap seconds not supported. -/
+  /-- Second of minute [0, 59]. Only leap-second aware APIs (`parseIso8601Leap`,
+      `LeapSecondTable`) produce 60; the rest of the library ignores leap seconds. -/
   second : UInt8
   /-- Nanosecond of second [0, 999999999]. -/
   nanosecond : UInt32
@@ -98,11 +99,86 @@ def nowLocal : IO DateTime := do
   let ts ← Timestamp.now
   fromTimestampLocal ts
 
-/-- Get the current timezone offset in seconds (local - UTC).
-    Positive for east of UTC, negative for west. -/
-def getTimezoneOffset : IO Int32 :=
+/-- Get the current timezone offset in seconds (local - UTC), computed
+    through libc on every call. Prefer `getTimezoneOffset`. -/
+def getTimezoneOffsetUncached : IO Int32 :=
   getTimezoneOffsetFFI
 
+/-- What identifies the configured local zone: `TZ`, the file
+    /etc/localtime resolves to, and that file's modification time. The
+    target is part of the key because re-pointing the symlink (as
+    `timedatectl set-timezone` does) leaves mtimes unchanged when every
+    zone file shares one. -/
+structure LocalZoneKey where
+  tzEnv : Option String
+  target : Option System.FilePath
+  mtime : Option IO.FS.SystemTime
+  deriving BEq
+
+/-- Read the key for the zone configured through `TZ` and `path`. -/
+def LocalZoneKey.read (path : System.FilePath := "/etc/localtime") : IO LocalZoneKey := do
+  let tzEnv ← IO.getEnv "TZ"
+  try
+    let target ← IO.FS.realPath path
+    return { tzEnv, target := some target, mtime := some (← target.metadata).modified }
+  catch _ =>
+    return { tzEnv, target := none, mtime := none }
+
+/-- The cached local UTC offset and the conditions under which it holds. -/
+structure LocalOffsetCache where
+  span : OffsetSpan
+  /-- Local zone configuration when the cache was filled. -/
+  key : LocalZoneKey
+  /-- Wall-clock second after which the key is checked again. -/
+  recheckAt : Int
+
+initialize localOffsetCacheRef : IO.Ref (Option LocalOffsetCache) ← IO.mkRef none
+
+/-- Seconds between checks of `TZ` and /etc/localtime for changes. -/
+def localOffsetRecheckSeconds : Int := 1
+
+/-- How far ahead libc zones, which have no transition data, are probed
+    for the next offset change. -/
+def localOffsetProbeSeconds : UInt32 := 604800
+
+private def fillLocalOffsetCache (now : Timestamp) : IO Int32 := do
+  let tz ← Timezone.localTz
+  let mut span ← tz.offsetSpan now
+  if (← tz.source) == .libc then
+    -- Hold the offset until the next change libc reports, or until the
+    -- end of the probed window when there is none
+    let horizon := now.addSeconds localOffsetProbeSeconds.toNat
+    let stop := (← tz.probeNextTransition now localOffsetProbeSeconds).getD horizon
+    span := { span with start := some now, stop := some stop }
+  localOffsetCacheRef.set (some {
+    span, key := ← LocalZoneKey.read, recheckAt := now.seconds + localOffsetRecheckSeconds })
+  return span.offset
+
+/-- Get the current timezone offset in seconds (local - UTC).
+    Positive for east of UTC, negative for west.
+
+    The offset is cached together with the interval over which it holds,
+    so most calls are a clock read and a comparison. It is recomputed at
+    DST transitions, and when `TZ`, the target of /etc/localtime or its
+    modification time changes (checked at most once per
+    `localOffsetRecheckSeconds`). -/
+def getTimezoneOffset : IO Int32 := do
+  let now ← Timestamp.now
+  match ← localOffsetCacheRef.get with
+  | some c =>
+    if now.seconds < c.recheckAt && c.span.contains now then
+      return c.span.offset
+    -- Time to look for configuration changes
+    if c.span.contains now && (← LocalZoneKey.read) == c.key then
+      localOffsetCacheRef.set (some { c with recheckAt := now.seconds + localOffsetRecheckSeconds })
+      return c.span.offset
+    fillLocalOffsetCache now
+  | none => fillLocalOffsetCache now
+
+/-- Drop the cached local offset so the next read recomputes it. -/
+def invalidateTimezoneOffsetCache : IO Unit :=
+  localOffsetCacheRef.set none
+
 -- ============================================================================
 -- EIO versions (explicit error handling)
 -- ============================================================================
@@ -553,14 +629,8 @@ private def parseFractionalSeconds (s : String) (pos : Nat) : Nat × Nat :=
   termination_by (9 - count)
   go pos 0 0
 
-/-- Parse ISO 8601 date/time string.
-    Accepted formats:
-    - "YYYY-MM-DD" (date only, time defaults to 00:00:00)
-    - "YYYY-MM-DDTHH:MM:SS" (with 'T' separator)
-    - "YYYY-MM-DD HH:MM:SS" (with space separator)
-    - "YYYY-MM-DDTHH:MM:SS.NNNNNNNNN" (with fractional seconds)
-    - Timezone suffixes like "Z" or "+05:00" are parsed but ignored (DateTime is timezone-naive). -/
-def parseIso8601 (s : String) : ParseResult DateTime := do
+/-- Shared ISO 8601 parser; `maxSecond` is 59, or 60 to admit leap seconds. -/
+private def parseIso8601Core (s : String) (maxSecond : Nat) : ParseResult DateTime := do
   let s := s.trim
   if s.isEmpty then throw "empty input"
 
@@ -600,7 +670,7 @@ def parseIso8601 (s : String) : ParseResult DateTime := do
   if minute > 59 then throw s!"invalid minute: {minute}"
   let pos ← optionToExcept (expectChar s pos ':') "expected ':' after minute"
   let (second, pos) ← optionToExcept (parseDigits s pos 2) "expected 2-digit second"
-  if second > 59 then throw s!"invalid second: {second}"
+  if second > maxSecond then throw s!"invalid second: {second}"
 
   -- Parse optional fractional seconds
   let (nanosecond, _pos) :=
@@ -615,6 +685,22 @@ def parseIso8601 (s : String) : ParseResult DateTime := do
            hour := UInt8.ofNat hour, minute := UInt8.ofNat minute, second := UInt8.ofNat second,
            nanosecond := UInt32.ofNat nanosecond }
 
+/-- Parse ISO 8601 date/time string.
+    Accepted formats:
+    - "YYYY-MM-DD" (date only, time defaults to 00:00:00)
+    - "YYYY-MM-DDTHH:MM:SS" (with 'T' separator)
+    - "YYYY-MM-DD HH:MM:SS" (with space separator)
+    - "YYYY-MM-DDTHH:MM:SS.NNNNNNNNN" (with fractional seconds)
+    - Timezone suffixes like "Z" or "+05:00" are parsed but ignored (DateTime is timezone-naive). -/
+def parseIso8601 (s : String) : ParseResult DateTime :=
+  parseIso8601Core s 59
+
+/-- Parse ISO 8601 like `parseIso8601`, but also accept a leap second
+    (`:60`) in the seconds field. Whether that leap second actually
+    occurred is not checked here; see `LeapSecondTable.parseUtc`. -/
+def parseIso8601Leap (s : String) : ParseResult DateTime :=
+  parseIso8601Core s 60
+
 /-- Parse date only: "YYYY-MM-DD".
     Time components default to 00:00:00. -/
 def parseDate (s : String) : ParseResult DateTime :=
@@ -646,42 +732,94 @@ def parseTime (s : String) : ParseResult DateTime := do
            hour := UInt8.ofNat hour, minute := UInt8.ofNat minute, second := UInt8.ofNat second,
            nanosecond := UInt32.ofNat nanosecond }
 
+-- ============================================================================
+-- Epoch-day conversions (pure)
+-- ============================================================================
+
+/-- Days since 1970-01-01 for a proleptic Gregorian date.
+    Era-based algorithm (Hinnant's `days_from_civil`); exact for all years. -/
+def daysFromCivil (year : Int) (month day : Nat) : Int :=
+  let y := if month ≤ 2 then year - 1 else year
+  let era := y.fdiv 400
+  let yoe := (y - era * 400).toNat
+  let mp := (month + 9) % 12
+  let doy := (153 * mp + 2) / 5 + day - 1
+  let doe := yoe * 365 + yoe / 4 - yoe / 100 + doy
+  era * 146097 + (doe : Int) - 719468
+
+/-- Inverse of `daysFromCivil`: (year, month, day) for days since 1970-01-01. -/
+def civilFromDays (days : Int) : Int × Nat × Nat :=
+  let z := days + 719468
+  let era := z.fdiv 146097
+  let doe := (z - era * 146097).toNat
+  let yoe := (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365
+  let doy := doe - (365 * yoe + yoe / 4 - yoe / 100)
+  let mp := (5 * doy + 2) / 153
+  let day := doy - (153 * mp + 2) / 5 + 1
+  let month := if mp < 10 then mp + 3 else mp - 9
+  let year := (yoe : Int) + era * 400 + (if month ≤ 2 then 1 else 0)
+  (year, month, day)
+
+/-- Weekday of a day count since 1970-01-01 (which was a Thursday). -/
+def weekdayOfEpochDays (days : Int) : Weekday :=
+  Weekday.fromNat ((days + 4).fmod 7).toNat
+
+/-- Days since 1970-01-01 for this DateTime's date (time fields ignored). -/
+def toEpochDays (dt : DateTime) : Int :=
+  daysFromCivil dt.year.toInt dt.month.toNat dt.day.toNat
+
+/-- Build a DateTime from days since 1970-01-01 and time-of-day fields. -/
+def fromEpochDays (days : Int) (hour minute second : UInt8 := 0)
+    (nanosecond : UInt32 := 0) : DateTime :=
+  let (year, month, day) := civilFromDays days
+  { year := Int.toInt32 year, month := UInt8.ofNat month, day := UInt8.ofNat day,
+    hour, minute, second, nanosecond }
+
+/-- Seconds elapsed since midnight for this DateTime's time of day. -/
+def secondOfDay (dt : DateTime) : Nat :=
+  dt.hour.toNat * 3600 + dt.minute.toNat * 60 + dt.second.toNat
+
+/-- Convert a UTC DateTime to a Timestamp without going through libc. -/
+def toTimestampPure (dt : DateTime) : Timestamp :=
+  { seconds := dt.toEpochDays * 86400 + (dt.secondOfDay : Int),
+    nanoseconds := dt.nanosecond }
+
+/-- Convert a Timestamp to a UTC DateTime without going through libc. -/
+def fromTimestampUtcPure (ts : Timestamp) : DateTime :=
+  let days := ts.seconds.fdiv 86400
+  let sod := (ts.seconds.fmod 86400).toNat
+  fromEpochDays days (UInt8.ofNat (sod / 3600)) (UInt8.ofNat (sod % 3600 / 60))
+    (UInt8.ofNat (sod % 60)) ts.nanoseconds
+
+/-- Get the day of the week without a libc round trip. -/
+def weekdayPure (dt : DateTime) : Weekday :=
+  weekdayOfEpochDays dt.toEpochDays
+
 -- ============================================================================
 -- Arithmetic (Pure implementations)
 -- ============================================================================
 
-/-- Convert date to Julian Day Number (days since November 24, 4714 BC).
-    Used for efficient date arithmetic. -/
-private def toJulianDayNumber (dt : DateTime) : Int :=
-  let y := dt.year.toInt
-  let m := dt.month.toNat
-  let d := dt.day.toNat
-  -- Algorithm from Wikipedia: Julian day
-  let a := (14 - m) / 12
-  let yAdj := y + 4800 - a
-  let mAdj := m + 12 * a - 3
-  d + (153 * mAdj + 2) / 5 + 365 * yAdj + yAdj / 4 - yAdj / 100 + yAdj / 400 - 32045
-
-/-- Convert Julian Day Number back to date components.
-    Time components are preserved from the original DateTime. -/
-private def fromJulianDayNumber (jdn : Int) (hour minute second : UInt8) (nanosecond : UInt32) : DateTime :=
-  -- Inverse algorithm
-  let a := jdn + 32044
-  let b := (4 * a + 3) / 146097
-  let c := a - 146097 * b / 4
-  let d := (4 * c + 3) / 1461
-  let e := c - 1461 * d / 4
-  let m := (5 * e + 2) / 153
-  let day := e - (153 * m + 2) / 5 + 1
-  let month := m + 3 - 12 * (m / 10)
-  let year := 100 * b + d - 4800 + m / 10
-  { year := Int.toInt32 year, month := UInt8.ofNat month.toNat, day := UInt8.ofNat day.toNat,
-    hour, minute, second, nanosecond }
+/-- Shift a DateTime by whole seconds plus `nanos` (< 1e9) with a single
+    normalization: the time of day absorbs the offset, and the date is
+    decoded once (and only when the day actually changes). -/
+private def shiftPure (dt : DateTime) (seconds : Int) (nanos : Nat) : DateTime :=
+  let nano := dt.nanosecond.toNat + nanos
+  let total : Int := (dt.secondOfDay : Int) + seconds + (nano / 1000000000 : Nat)
+  let nano := nano % 1000000000
+  let dayDelta := total.fdiv 86400
+  let sod := (total.fmod 86400).toNat
+  let hour := UInt8.ofNat (sod / 3600)
+  let minute := UInt8.ofNat (sod % 3600 / 60)
+  let second := UInt8.ofNat (sod % 60)
+  if dayDelta == 0 then
+    { dt with hour := hour, minute := minute, second := second, nanosecond := UInt32.ofNat nano }
+  else
+    fromEpochDays (dt.toEpochDays + dayDelta) hour minute second (UInt32.ofNat nano)
 
 /-- Add days to a DateTime (pure, no IO). -/
 def addDaysPure (dt : DateTime) (days : Int) : DateTime :=
-  let jdn := toJulianDayNumber dt + days
-  fromJulianDayNumber jdn dt.hour dt.minute dt.second dt.nanosecond
+  if days == 0 then dt
+  else fromEpochDays (dt.toEpochDays + days) dt.hour dt.minute dt.second dt.nanosecond
 
 /-- Add months to a DateTime (pure, no IO).
     If the resulting day is invalid (e.g., Jan 31 + 1 month = Feb 31),
@@ -705,51 +843,19 @@ def addYearsPure (dt : DateTime) (years : Int) : DateTime :=
 
 /-- Add hours to a DateTime, with proper day overflow (pure, no IO). -/
 def addHoursPure (dt : DateTime) (hours : Int) : DateTime :=
-  let totalHours : Int := dt.hour.toNat + hours
-  let dayDelta := totalHours / 24
-  let newHourRaw := totalHours % 24
-  let (dayDelta, newHour) :=
-    if newHourRaw < 0 then (dayDelta - 1, newHourRaw + 24)
-    else (dayDelta, newHourRaw)
-  let newDt := addDaysPure dt dayDelta
-  { newDt with hour := UInt8.ofNat newHour.toNat }
+  shiftPure dt (hours * 3600) 0
 
 /-- Add minutes to a DateTime, with proper hour/day overflow (pure, no IO). -/
 def addMinutesPure (dt : DateTime) (minutes : Int) : DateTime :=
-  let totalMinutes : Int := dt.minute.toNat + minutes
-  let hourDelta := totalMinutes / 60
-  let newMinuteRaw := totalMinutes % 60
-  let (hourDelta, newMinute) :=
-    if newMinuteRaw < 0 then (hourDelta - 1, newMinuteRaw + 60)
-    else (hourDelta, newMinuteRaw)
-  let newDt := addHoursPure dt hourDelta
-  { newDt with minute := UInt8.ofNat newMinute.toNat }
+  shiftPure dt (minutes * 60) 0
 
 /-- Add seconds to a DateTime, with proper minute/hour/day overflow (pure, no IO). -/
 def addSecondsPure (dt : DateTime) (seconds : Int) : DateTime :=
-  let totalSeconds : Int := dt.second.toNat + seconds
-  let minuteDelta := totalSeconds / 60
-  let newSecondRaw := totalSeconds % 60
-  let (minuteDelta, newSecond) :=
-    if newSecondRaw < 0 then (minuteDelta - 1, newSecondRaw + 60)
-    else (minuteDelta, newSecondRaw)
-  let newDt := addMinutesPure dt minuteDelta
-  { newDt with second := UInt8.ofNat newSecond.toNat }
+  shiftPure dt seconds 0
 
 /-- Add a Duration to a DateTime (pure, no IO). -/
 def addDurationPure (dt : DateTime) (d : Duration) : DateTime :=
-  -- Convert duration to seconds and remaining nanoseconds
-  let totalNanos : Int := dt.nanosecond.toNat + (d.nanoseconds % 1000000000)
-  let secDelta := d.nanoseconds / 1000000000
-  let (secDelta, newNano) :=
-    if totalNanos < 0 then
-      (secDelta - 1, totalNanos + 1000000000)
-    else if totalNanos >= 1000000000 then
-      (secDelta + 1, totalNanos - 1000000000)
-    else
-      (secDelta, totalNanos)
-  let newDt := addSecondsPure dt secDelta
-  { newDt with nanosecond := UInt32.ofNat newNano.toNat }
+  shiftPure dt (d.nanoseconds.fdiv 1000000000) (d.nanoseconds.fmod 1000000000).toNat
 
 -- ============================================================================
 -- Arithmetic (IO wrappers for API consistency)
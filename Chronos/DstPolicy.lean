@@ -0,0 +1,104 @@
+/-
+  Chronos.DstPolicy
+  Explicit resolution of local wall times that a DST transition skips or
+  repeats.
+
+  Each wall time is classified with one search over the zone's offsets:
+  it maps to one instant, to two (a fall-back overlap), or to none (a
+  spring-forward gap). A policy then picks the instant. Whole arrays are
+  classified in a single FFI call.
+-/
+
+import Chronos.DateTime
+import Chronos.Timezone
+import Chronos.Error
+
+namespace Chronos
+
+/-- How a local wall time maps onto UTC instants. -/
+inductive LocalResolution where
+  /-- Exactly one instant reads as the wall time. -/
+  | unique (ts : Timestamp)
+  /-- The wall time is repeated; both instants read as it. -/
+  | ambiguous (earlier later : Timestamp)
+  /-- The wall time is skipped. `shiftedForward` applies the offset in
+      effect before the gap (what `mktime` returns); `shiftedBackward`
+      applies the offset after it. -/
+  | skipped (shiftedForward shiftedBackward : Timestamp)
+  deriving Repr, BEq, Inhabited
+
+/-- Choice of instant for skipped and repeated wall times. -/
+inductive DstPolicy where
+  /-- Earlier instant of a repeat; skipped times shift forward (as `mktime`). -/
+  | compatible
+  /-- Earlier instant of a repeat; skipped times shift backward. -/
+  | earlier
+  /-- Later instant of a repeat; skipped times shift forward. -/
+  | later
+  /-- No instant for either case. -/
+  | reject
+  deriving Repr, BEq, Inhabited
+
+namespace DstPolicy
+
+/-- The instant this policy picks, or `none` if it rejects the wall time. -/
+def pick : DstPolicy → LocalResolution → Option Timestamp
+  | _, .unique ts => some ts
+  | .reject, _ => none
+  | .later, .ambiguous _ b => some b
+  | _, .ambiguous a _ => some a
+  | .earlier, .skipped _ back => some back
+  | _, .skipped fwd _ => some fwd
+
+end DstPolicy
+
+namespace Timezone
+
+/-- Raw FFI: `(count, first, second)` per local second, flattened. -/
+@[extern "chronos_timezone_local_candidates"]
+private opaque localCandidatesFFI (tz : @& Timezone) (locals : @& Array Int) : IO (Array Int)
+
+/-- Classify many local wall times in one call. -/
+def resolveLocalAll (tz : Timezone) (dts : Array DateTime) : IO (Array LocalResolution) := do
+  let raw ← localCandidatesFFI tz (dts.map (·.toTimestampPure.seconds))
+  return dts.mapIdx fun i dt =>
+    let ts (s : Int) : Timestamp := { seconds := s, nanoseconds := dt.nanosecond }
+    let a := ts raw[3 * i + 1]!
+    let b := ts raw[3 * i + 2]!
+    let count := raw[3 * i]!
+    if count == 2 then .ambiguous a b
+    else if count == 0 then .skipped a b
+    else .unique a
+
+/-- Classify one local wall time against the zone's transitions. -/
+def resolveLocal (tz : Timezone) (dt : DateTime) : IO LocalResolution := do
+  return (← tz.resolveLocalAll #[dt])[0]!
+
+end Timezone
+
+namespace DateTime
+
+/-- Convert a local DateTime in `tz` to UTC, resolving skipped and repeated
+    wall times by `policy`. Fails with `timezoneConversionFailed` if the
+    policy rejects the wall time. -/
+def toTimestampInTimezoneWith (dt : DateTime) (tz : Timezone) (policy : DstPolicy) :
+    ChronosM Timestamp := do
+  let r ← ChronosM.liftIO (tz.resolveLocal dt) fun e =>
+    ChronosError.timezoneConversionFailed (toString e)
+  match policy.pick r with
+  | some ts => pure ts
+  | none =>
+    let what := match r with
+      | .skipped .. => "does not exist"
+      | _ => "is ambiguous"
+    throw (ChronosError.timezoneConversionFailed s!"{dt} {what} in this timezone")
+
+/-- Convert many local DateTimes in `tz` to UTC in one call; `none` where
+    `policy` rejects the wall time. -/
+def toTimestampsInTimezone (dts : Array DateTime) (tz : Timezone)
+    (policy : DstPolicy := .compatible) : IO (Array (Option Timestamp)) := do
+  return (← tz.resolveLocalAll dts).map policy.pick
+
+end DateTime
+
+end Chronos
@@ -0,0 +1,181 @@
+/-
+  Chronos.Interval
+  Half-open time intervals and an augmented interval tree for
+  overlap and stabbing queries.
+
+  The tree is an implicit balanced binary search tree over an array
+  sorted by start: the node for the slice `[lo, hi)` is the middle
+  element, and each node records the latest end in its subtree.
+  Construction is one sort plus one linear pass. A query prunes
+  subtrees that start after its end or end before its start, so it
+  visits O(min(n, k log n)) nodes for k results, since each reported
+  interval can cost a root-to-leaf path.
+-/
+
+import Chronos.Timestamp
+
+namespace Chronos
+
+/-- A half-open time interval `[start, stop)`. Intervals with
+    `stop ≤ start` are empty. -/
+structure Interval where
+  start : Timestamp
+  /-- Exclusive end. -/
+  stop : Timestamp
+  deriving Repr, BEq, Inhabited, DecidableEq
+
+namespace Interval
+
+private def tsMin (a b : Timestamp) : Timestamp := if a ≤ b then a else b
+private def tsMax (a b : Timestamp) : Timestamp := if a ≤ b then b else a
+
+/-- Whether the interval contains no instants. -/
+def isEmpty (i : Interval) : Bool := i.stop ≤ i.start
+
+/-- Length of the interval (zero when empty). -/
+def duration (i : Interval) : Duration :=
+  if i.isEmpty then Duration.zero else i.stop.duration i.start
+
+/-- Whether `t` lies in `[start, stop)`. -/
+def contains (i : Interval) (t : Timestamp) : Bool := i.start ≤ t && t < i.stop
+
+/-- Whether two intervals share at least one instant. -/
+def overlaps (a b : Interval) : Bool :=
+  !a.isEmpty && !b.isEmpty && a.start < b.stop && b.start < a.stop
+
+/-- The common part of two intervals, if non-empty. -/
+def intersection? (a b : Interval) : Option Interval :=
+  let i : Interval := { start := tsMax a.start b.start, stop := tsMin a.stop b.stop }
+  if i.isEmpty then none else some i
+
+/-- The smallest interval covering both (ignoring empty operands). -/
+def hull (a b : Interval) : Interval :=
+  if a.isEmpty then b
+  else if b.isEmpty then a
+  else { start := tsMin a.start b.start, stop := tsMax a.stop b.stop }
+
+/-- The union of two intervals when it is a single interval, i.e. when
+    they overlap or touch. -/
+def union? (a b : Interval) : Option Interval :=
+  if a.isEmpty then some b
+  else if b.isEmpty then some a
+  else if a.start ≤ b.stop && b.start ≤ a.stop then some (hull a b)
+  else none
+
+/-- The interval strictly between two disjoint intervals, if there is one. -/
+def gap? (a b : Interval) : Option Interval :=
+  if a.isEmpty || b.isEmpty then none
+  else
+    let g : Interval := { start := tsMin a.stop b.stop, stop := tsMax a.start b.start }
+    if g.isEmpty then none else some g
+
+/-- Merge overlapping and touching intervals into a sorted, disjoint list.
+    Empty intervals are dropped. -/
+def mergeAll (xs : Array Interval) : Array Interval := Id.run do
+  let sorted := (xs.filter (!·.isEmpty)).qsort (fun a b => a.start < b.start)
+  let mut out : Array Interval := Array.mkEmpty sorted.size
+  for i in sorted do
+    match out.back? with
+    | some last =>
+      if i.start ≤ last.stop then
+        out := out.pop.push { last with stop := tsMax last.stop i.stop }
+      else out := out.push i
+    | none => out := out.push i
+  return out
+
+/-- Gaps between the merged intervals of `xs`, in order. -/
+def gaps (xs : Array Interval) : Array Interval := Id.run do
+  let merged := mergeAll xs
+  let mut out : Array Interval := #[]
+  for k in [1:merged.size] do
+    out := out.push { start := merged[k - 1]!.stop, stop := merged[k]!.start }
+  return out
+
+end Interval
+
+-- ============================================================================
+-- Interval tree
+-- ============================================================================
+
+/-- A static augmented interval tree mapping intervals to values. -/
+structure IntervalTree (α : Type) where
+  /-- Non-empty intervals with their values, sorted by start. -/
+  items : Array (Interval × α)
+  /-- `maxEnd[mid]` is the latest `stop` in the subtree rooted at `mid`. -/
+  maxEnd : Array Timestamp
+  deriving Inhabited
+
+namespace IntervalTree
+
+/-- Fill `maxEnd` for the subtree over `[lo, hi)`, returning its latest end. -/
+private partial def fill (items : Array (Interval × α)) (lo hi : Nat)
+    (maxEnd : Array Timestamp) : Array Timestamp × Timestamp :=
+  let mid := (lo + hi) / 2
+  let own := items[mid]!.1.stop
+  let (maxEnd, m) :=
+    if lo < mid then
+      let (maxEnd, l) := fill items lo mid maxEnd
+      (maxEnd, if own ≤ l then l else own)
+    else (maxEnd, own)
+  let (maxEnd, m) :=
+    if mid + 1 < hi then
+      let (maxEnd, r) := fill items (mid + 1) hi maxEnd
+      (maxEnd, if m ≤ r then r else m)
+    else (maxEnd, m)
+  (maxEnd.set! mid m, m)
+
+/-- Build a tree from interval/value pairs. Empty intervals are dropped. -/
+def build (xs : Array (Interval × α)) : IntervalTree α :=
+  let items := (xs.filter (!·.1.isEmpty)).qsort (fun a b => a.1.start < b.1.start)
+  if items.isEmpty then { items, maxEnd := #[] }
+  else { items, maxEnd := (fill items 0 items.size (Array.replicate items.size Timestamp.epoch)).1 }
+
+/-- Build a tree of bare intervals. -/
+def ofIntervals (xs : Array Interval) : IntervalTree Unit :=
+  build (xs.map (·, ()))
+
+/-- Number of stored intervals. -/
+def size (t : IntervalTree α) : Nat := t.items.size
+
+private partial def collect (t : IntervalTree α) (q : Interval) (lo hi : Nat)
+    (acc : Array (Interval × α)) : Array (Interval × α) :=
+  if hi ≤ lo then acc
+  else
+    let mid := (lo + hi) / 2
+    -- Nothing in this subtree ends after the query starts
+    if t.maxEnd[mid]! ≤ q.start then acc
+    else
+      let acc := collect t q lo mid acc
+      let (iv, v) := t.items[mid]!
+      -- This node and its right subtree start at or after the query end
+      if q.stop ≤ iv.start then acc
+      else
+        let acc := if q.start < iv.stop then acc.push (iv, v) else acc
+        collect t q (mid + 1) hi acc
+
+private partial def anyIn (t : IntervalTree α) (q : Interval) (lo hi : Nat) : Bool :=
+  if hi ≤ lo then false
+  else
+    let mid := (lo + hi) / 2
+    if t.maxEnd[mid]! ≤ q.start then false
+    else if anyIn t q lo mid then true
+    else
+      let iv := t.items[mid]!.1
+      if q.stop ≤ iv.start then false
+      else q.start < iv.stop || anyIn t q (mid + 1) hi
+
+/-- All stored intervals overlapping `q`, ordered by start. -/
+def overlapping (t : IntervalTree α) (q : Interval) : Array (Interval × α) :=
+  if q.isEmpty then #[] else collect t q 0 t.items.size #[]
+
+/-- Whether any stored interval overlaps `q` (stops at the first hit). -/
+def overlapsAny (t : IntervalTree α) (q : Interval) : Bool :=
+  !q.isEmpty && anyIn t q 0 t.items.size
+
+/-- All stored intervals containing the instant `p` (stabbing query). -/
+def stab (t : IntervalTree α) (p : Timestamp) : Array (Interval × α) :=
+  t.overlapping { start := p, stop := p.addNanoseconds 1 }
+
+end IntervalTree
+
+end Chronos
@@ -0,0 +1,291 @@
+/-
+  Chronos.LeapSecond
+  Leap-second table and UTC/TAI/GPS time scale conversions.
+
+  Timestamps on every scale count seconds on the Unix epoch grid:
+  a TAI reading is the UTC Unix reading plus TAI−UTC, and GPS readings
+  count from the GPS epoch (1980-01-06T00:00:00 UTC) with GPS = TAI − 19 s.
+  Before 1972 UTC did not differ from TAI by whole seconds; conversions
+  there use the 1972 offset of 10 s.
+-/
+
+import Chronos.DateTime
+
+namespace Chronos
+
+/-- A step in TAI−UTC. -/
+structure LeapSecondEntry where
+  /-- UTC Unix seconds at which the new offset takes effect. -/
+  effective : Int
+  /-- TAI − UTC in seconds from `effective` onwards. -/
+  taiMinusUtc : Int
+  deriving Repr, BEq, Inhabited
+
+/-- A sorted table of TAI−UTC offsets. -/
+structure LeapSecondTable where
+  entries : Array LeapSecondEntry
+  /-- Unix seconds after which the table may be missing announced leap seconds. -/
+  expires : Option Int := none
+  deriving Repr, Inhabited
+
+namespace LeapSecondTable
+
+/-- Seconds between the NTP epoch (1900) and the Unix epoch (1970). -/
+private def ntpToUnix : Int := 2208988800
+
+/-- GPS epoch, 1980-01-06T00:00:00 UTC, as Unix seconds. -/
+def gpsEpoch : Int := 315964800
+
+/-- TAI − GPS, fixed by definition of the GPS time scale. -/
+def taiMinusGps : Int := 19
+
+/-- Location of the IERS/IANA leap-seconds.list on most Unix systems. -/
+def systemListPath : System.FilePath := "/usr/share/zoneinfo/leap-seconds.list"
+
+/-- The leap-second table compiled into the library (IERS Bulletin C 70). -/
+def builtin : LeapSecondTable where
+  entries := #[
+    ⟨63072000, 10⟩, ⟨78796800, 11⟩, ⟨94694400, 12⟩, ⟨126230400, 13⟩,
+    ⟨157766400, 14⟩, ⟨189302400, 15⟩, ⟨220924800, 16⟩, ⟨252460800, 17⟩,
+    ⟨283996800, 18⟩, ⟨315532800, 19⟩, ⟨362793600, 20⟩, ⟨394329600, 21⟩,
+    ⟨425865600, 22⟩, ⟨489024000, 23⟩, ⟨567993600, 24⟩, ⟨631152000, 25⟩,
+    ⟨662688000, 26⟩, ⟨709948800, 27⟩, ⟨741484800, 28⟩, ⟨773020800, 29⟩,
+    ⟨820454400, 30⟩, ⟨867715200, 31⟩, ⟨915148800, 32⟩, ⟨1136073600, 33⟩,
+    ⟨1230768000, 34⟩, ⟨1341100800, 35⟩, ⟨1435708800, 36⟩, ⟨1483228800, 37⟩
+  ]
+  expires := some 1782604800
+
+-- ============================================================================
+-- Lookup
+-- ============================================================================
+
+/-- Index of the last entry with `key e ≤ t` (binary search), if any. -/
+private def searchLast (entries : Array LeapSecondEntry) (key : LeapSecondEntry → Int)
+    (t : Int) : Option Nat := Id.run do
+  let mut lo := 0
+  let mut hi := entries.size
+  while lo < hi do
+    let mid := (lo + hi) / 2
+    if key entries[mid]! ≤ t then lo := mid + 1 else hi := mid
+  return if lo == 0 then none else some (lo - 1)
+
+/-- TAI − UTC for the first entry, used for instants before the table. -/
+private def firstOffset (table : LeapSecondTable) : Int :=
+  (table.entries[0]?.map (·.taiMinusUtc)).getD 0
+
+/-- TAI − UTC in effect at a UTC Unix second. -/
+def offsetAt (table : LeapSecondTable) (utcSeconds : Int) : Int :=
+  match searchLast table.entries (·.effective) utcSeconds with
+  | some i => table.entries[i]!.taiMinusUtc
+  | none => table.firstOffset
+
+/-- Whether a positive leap second is inserted right after the UTC second `utcSeconds`. -/
+def isLeapSecondAfter (table : LeapSecondTable) (utcSeconds : Int) : Bool :=
+  match searchLast table.entries (·.effective) (utcSeconds + 1) with
+  | some i =>
+    i > 0 && table.entries[i]!.effective == utcSeconds + 1 &&
+      table.entries[i]!.taiMinusUtc > table.entries[i - 1]!.taiMinusUtc
+  | none => false
+
+/-- UTC range `[lo, hi)` sharing one offset around `s`, with that offset. -/
+private def segmentUtc (table : LeapSecondTable) (s : Int) : Int × Int × Int :=
+  let far : Int := 1 <<< 62
+  match searchLast table.entries (·.effective) s with
+  | some i =>
+    let hi := (table.entries[i + 1]?.map (·.effective)).getD far
+    (table.entries[i]!.effective, hi, table.entries[i]!.taiMinusUtc)
+  | none =>
+    let hi := (table.entries[0]?.map (·.effective)).getD far
+    (-far, hi, table.firstOffset)
+
+/-- TAI range `[lo, hi)` around `s` on which UTC = TAI − offset, with that
+    offset; `none` when `s` falls inside an inserted leap second. -/
+private def segmentTai (table : LeapSecondTable) (s : Int) : Option (Int × Int × Int) :=
+  let far : Int := 1 <<< 62
+  match searchLast table.entries (fun e => e.effective + e.taiMinusUtc) s with
+  | some i =>
+    let off := table.entries[i]!.taiMinusUtc
+    let hi := (table.entries[i + 1]?.map (·.effective + off)).getD far
+    if s < hi then some (table.entries[i]!.effective + off, hi, off) else none
+  | none =>
+    let off := table.firstOffset
+    let hi := (table.entries[0]?.map (·.effective + off)).getD far
+    some (-far, hi, off)
+
+-- ============================================================================
+-- Single-value conversions
+-- ============================================================================
+
+/-- Convert a UTC timestamp to TAI. -/
+def utcToTai (table : LeapSecondTable) (utc : Timestamp) : Timestamp :=
+  utc.addSeconds (table.offsetAt utc.seconds)
+
+/-- Convert a TAI timestamp to UTC. The flag is `true` when the instant lies
+    inside an inserted leap second, in which case the returned Unix time is
+    the preceding 23:59:59 (Unix time cannot represent 23:59:60). -/
+def taiToUtcLeap (table : LeapSecondTable) (tai : Timestamp) : Timestamp × Bool :=
+  match table.segmentTai tai.seconds with
+  | some (_, _, off) => (tai.subSeconds off, false)
+  | none =>
+    let i := (searchLast table.entries (fun e => e.effective + e.taiMinusUtc) tai.seconds).getD 0
+    ({ tai with seconds := table.entries[i + 1]!.effective - 1 }, true)
+
+/-- Convert a TAI timestamp to UTC; leap seconds map onto the preceding second. -/
+def taiToUtc (table : LeapSecondTable) (tai : Timestamp) : Timestamp :=
+  (table.taiToUtcLeap tai).1
+
+/-- Convert a TAI timestamp to GPS time (seconds since the GPS epoch). -/
+def taiToGps (tai : Timestamp) : Timestamp :=
+  tai.subSeconds (taiMinusGps + gpsEpoch)
+
+/-- Convert a GPS time (seconds since the GPS epoch) to TAI. -/
+def gpsToTai (gps : Timestamp) : Timestamp :=
+  gps.addSeconds (taiMinusGps + gpsEpoch)
+
+/-- Convert a UTC timestamp to GPS time. -/
+def utcToGps (table : LeapSecondTable) (utc : Timestamp) : Timestamp :=
+  taiToGps (table.utcToTai utc)
+
+/-- Convert a GPS time to UTC. -/
+def gpsToUtc (table : LeapSecondTable) (gps : Timestamp) : Timestamp :=
+  table.taiToUtc (gpsToTai gps)
+
+/-- Split a GPS time into (week number, seconds into the week). -/
+def gpsWeek (gps : Timestamp) : Int × Nat :=
+  (gps.seconds.fdiv 604800, (gps.seconds.fmod 604800).toNat)
+
+-- ============================================================================
+-- Bulk conversions
+-- ============================================================================
+
+/-- Convert an array of UTC timestamps to TAI. The offset segment of the
+    previous element is reused, so sorted input needs almost no searches. -/
+def utcToTaiAll (table : LeapSecondTable) (tss : Array Timestamp) : Array Timestamp := Id.run do
+  let mut out : Array Timestamp := Array.mkEmpty tss.size
+  let mut seg : Int × Int × Int := (1, 0, 0)
+  for ts in tss do
+    if !(seg.1 ≤ ts.seconds && ts.seconds < seg.2.1) then
+      seg := table.segmentUtc ts.seconds
+    out := out.push (ts.addSeconds seg.2.2)
+  return out
+
+/-- Convert an array of TAI timestamps to UTC, reusing the previous segment. -/
+def taiToUtcAll (table : LeapSecondTable) (tss : Array Timestamp) : Array Timestamp := Id.run do
+  let mut out : Array Timestamp := Array.mkEmpty tss.size
+  let mut seg : Int × Int × Int := (1, 0, 0)
+  for ts in tss do
+    if seg.1 ≤ ts.seconds && ts.seconds < seg.2.1 then
+      out := out.push (ts.subSeconds seg.2.2)
+    else match table.segmentTai ts.seconds with
+      | some s =>
+        seg := s
+        out := out.push (ts.subSeconds s.2.2)
+      | none => out := out.push (table.taiToUtc ts)
+  return out
+
+/-- Convert an array of UTC timestamps to GPS time. -/
+def utcToGpsAll (table : LeapSecondTable) (tss : Array Timestamp) : Array Timestamp :=
+  (table.utcToTaiAll tss).map taiToGps
+
+/-- Convert an array of GPS times to UTC. -/
+def gpsToUtcAll (table : LeapSecondTable) (tss : Array Timestamp) : Array Timestamp :=
+  table.taiToUtcAll (tss.map gpsToTai)
+
+-- ============================================================================
+-- Leap-second aware parsing and formatting
+-- ============================================================================
+
+/-- Convert a TAI instant to a UTC DateTime, with `second = 60` inside a leap second. -/
+def taiToUtcDateTime (table : LeapSecondTable) (tai : Timestamp) : DateTime :=
+  let (utc, leap) := table.taiToUtcLeap tai
+  let dt := DateTime.fromTimestampUtcPure utc
+  if leap then { dt with second := 60 } else dt
+
+/-- Format a TAI instant as an ISO 8601 UTC string; leap seconds render as `:60`. -/
+def formatUtc (table : LeapSecondTable) (tai : Timestamp) : String :=
+  (table.taiToUtcDateTime tai).toIso8601
+
+/-- Parse an ISO 8601 UTC string to a TAI instant. `:60` is accepted only
+    where the table records an inserted leap second. -/
+def parseUtc (table : LeapSecondTable) (s : String) : Except String Timestamp := do
+  let dt ← DateTime.parseIso8601Leap s
+  if dt.second == 60 then
+    let before := ({ dt with second := 59 } : DateTime).toTimestampPure
+    if !table.isLeapSecondAfter before.seconds then
+      throw s!"no leap second at {s}"
+    return (table.utcToTai before).addSeconds 1
+  return table.utcToTai dt.toTimestampPure
+
+-- ============================================================================
+-- leap-seconds.list loading
+-- ============================================================================
+
+/-- Split a line into whitespace-separated tokens. -/
+private def tokens (cs : List Char) : List String :=
+  let (acc, cur) := cs.foldl (init := (([] : List String), ([] : List Char))) fun (acc, cur) c =>
+    if c.isWhitespace then
+      (if cur.isEmpty then acc else String.ofList cur.reverse :: acc, [])
+    else (acc, c :: cur)
+  (if cur.isEmpty then acc else String.ofList cur.reverse :: acc).reverse
+
+/-- Parse the IERS/IANA `leap-seconds.list` format: data lines of
+    "NTP-seconds TAI-UTC", `#` comments, and a `#@` expiry line. -/
+def parseList (content : String) : Except String LeapSecondTable := do
+  let mut entries : Array LeapSecondEntry := #[]
+  let mut expires : Option Int := none
+  for line in content.splitOn "\n" do
+    match line.trim.toList with
+    | [] => continue
+    | '#' :: '@' :: rest =>
+      match (tokens rest).head? >>= String.toNat? with
+      | some ntp => expires := some (ntp - ntpToUnix)
+      | none => throw s!"invalid expiry line: {line}"
+    | '#' :: _ => continue
+    | cs =>
+      match tokens cs with
+      | ntp :: off :: _ =>
+        match ntp.toNat?, off.toInt? with
+        | some t, some o =>
+          let e : LeapSecondEntry := { effective := t - ntpToUnix, taiMinusUtc := o }
+          if let some last := entries.back? then
+            if e.effective ≤ last.effective then throw s!"entries out of order at: {line}"
+          entries := entries.push e
+        | _, _ => throw s!"invalid data line: {line}"
+      | _ => throw s!"invalid data line: {line}"
+  if entries.isEmpty then throw "no leap-second entries"
+  return { entries, expires }
+
+/-- Load a table from a `leap-seconds.list` file. -/
+def loadFile (path : System.FilePath := systemListPath) : IO LeapSecondTable := do
+  let content ← IO.FS.readFile path
+  match parseList content with
+  | .ok table => return table
+  | .error e => throw (IO.userError s!"{path}: {e}")
+
+/-- Whether the table is past its expiry date at `now`. -/
+def isExpired (table : LeapSecondTable) (now : Timestamp) : Bool :=
+  match table.expires with
+  | some e => now.seconds ≥ e
+  | none => false
+
+-- ============================================================================
+-- Process-wide table
+-- ============================================================================
+
+initialize currentRef : IO.Ref LeapSecondTable ← IO.mkRef builtin
+
+/-- The process-wide table (initially `builtin`). -/
+def current : IO LeapSecondTable := currentRef.get
+
+/-- Reload the process-wide table from a `leap-seconds.list` file. The loaded
+    table replaces the current one unless it has fewer entries. -/
+def refresh (path : System.FilePath := systemListPath) : IO LeapSecondTable := do
+  let loaded ← loadFile path
+  let cur ← currentRef.get
+  if loaded.entries.size < cur.entries.size then return cur
+  currentRef.set loaded
+  return loaded
+
+end LeapSecondTable
+
+end Chronos
@@ -0,0 +1,90 @@
+/-
+  Chronos.LocalDays
+  DST-correct local day and hour boundaries, computed in bulk.
+
+  A local day is not always 24 hours: it is 23 hours on spring-forward
+  days and 25 on fall-back days, and in some zones midnight itself is
+  skipped. Boundaries are resolved for a whole date range in one FFI
+  call (one timezone switch), and events are then grouped by binary
+  search over the boundaries instead of converting each event.
+-/
+
+import Chronos.DateTime
+import Chronos.Timezone
+import Chronos.Interval
+import Chronos.TimestampIndex
+
+namespace Chronos
+
+namespace Timezone
+
+/-- Raw FFI: UTC seconds of local wall-clock boundaries for `days` days
+    starting at epoch day `firstDay`. With `stepHours ≥ 24` this is each
+    day's first instant plus the start of the following day; otherwise
+    every occurrence of each `stepHours`-aligned local hour. -/
+@[extern "chronos_timezone_wall_boundaries"]
+private opaque wallBoundariesFFI (tz : @& Timezone) (firstDay : Int) (days : UInt32)
+  (stepHours : UInt8) : IO (Array Int)
+
+/-- First instant of each local day from `first` (its date) for `days`
+    days, plus the start of the day after: `days + 1` instants. -/
+def dayBoundaries (tz : Timezone) (first : DateTime) (days : Nat) : IO (Array Timestamp) := do
+  let secs ← wallBoundariesFFI tz first.toEpochDays days.toUInt32 24
+  return secs.map Timestamp.fromSeconds
+
+/-- Local days from `first` (its date) for `days` days as UTC intervals.
+    Intervals are 23 or 25 hours long on DST transition days. -/
+def localDays (tz : Timezone) (first : DateTime) (days : Nat) : IO (Array Interval) := do
+  let bs ← tz.dayBoundaries first days
+  let mut out : Array Interval := Array.mkEmpty days
+  for k in [1:bs.size] do
+    out := out.push { start := bs[k - 1]!, stop := bs[k]! }
+  return out
+
+/-- Every local hour start within `days` days from `first`, followed by
+    the start of the next day. An hour repeated by a fall-back transition
+    appears twice; an hour skipped by spring-forward is omitted. With
+    `stepHours > 1` only hours divisible by it are included. -/
+def hourBoundaries (tz : Timezone) (first : DateTime) (days : Nat)
+    (stepHours : Nat := 1) : IO (Array Timestamp) := do
+  let step := if stepHours == 0 then 1 else min stepHours 24
+  let secs ← wallBoundariesFFI tz first.toEpochDays days.toUInt32 step.toUInt8
+  return secs.map Timestamp.fromSeconds
+
+-- ============================================================================
+-- Grouping by local day
+-- ============================================================================
+
+/-- Group timestamps by the local calendar day they fall on. Returns the
+    local date (at midnight) of each day that has events, ascending, with
+    that day's events in input order. Only the earliest and latest events
+    are converted individually. -/
+def groupByLocalDay (tz : Timezone) (events : Array Timestamp) :
+    IO (Array (DateTime × Array Timestamp)) := do
+  if events.isEmpty then return #[]
+  let mut lo := events[0]!
+  let mut hi := events[0]!
+  for e in events do
+    if e < lo then lo := e
+    if hi < e then hi := e
+  let firstDay := (← DateTime.fromTimestampInTimezone lo tz).toEpochDays
+  let lastDay := (← DateTime.fromTimestampInTimezone hi tz).toEpochDays
+  let days := (lastDay - firstDay).toNat + 1
+  let index := TimestampIndex.ofSorted (← tz.dayBoundaries (DateTime.fromEpochDays firstDay) days)
+  let mut buckets : Array (Array Timestamp) := Array.replicate days #[]
+  for e in events do
+    let k := min (index.upperBound e - 1) (days - 1)
+    buckets := buckets.modify k (·.push e)
+  let mut out : Array (DateTime × Array Timestamp) := #[]
+  for k in [0:days] do
+    if !buckets[k]!.isEmpty then
+      out := out.push (DateTime.fromEpochDays (firstDay + k), buckets[k]!)
+  return out
+
+/-- Count timestamps per local calendar day (days without events omitted). -/
+def countByLocalDay (tz : Timezone) (events : Array Timestamp) : IO (Array (DateTime × Nat)) := do
+  return (← tz.groupByLocalDay events).map fun (d, es) => (d, es.size)
+
+end Timezone
+
+end Chronos
@@ -0,0 +1,183 @@
+/-
+  Chronos.LogSeek
+  Binary search by time over large, sorted text logs.
+
+  The log is memory-mapped and never read whole. A search probes byte
+  offsets, resynchronizes to the next line start, and parses only the
+  timestamp at the head of that line, so finding a time range costs
+  O(log size) line reads. Lines whose head does not parse (stack traces,
+  wrapped messages) are skipped over while probing and stay attached to
+  the entry before them.
+-/
+
+import Chronos.DateTime
+
+namespace Chronos
+
+/-- Opaque handle to a read-only memory-mapped file. -/
+opaque MappedFilePointed : NonemptyType
+def MappedFile := MappedFilePointed.type
+instance : Nonempty MappedFile := MappedFilePointed.property
+
+namespace MappedFile
+
+@[extern "chronos_mapped_file_open"]
+private opaque openFFI (path : @& String) : IO MappedFile
+
+@[extern "chronos_mapped_file_size"]
+private opaque sizeFFI (mf : @& MappedFile) : UInt64
+
+@[extern "chronos_mapped_file_read"]
+private opaque readFFI (mf : @& MappedFile) (off len : UInt64) : IO ByteArray
+
+@[extern "chronos_mapped_file_find_byte"]
+private opaque findByteFFI (mf : @& MappedFile) (off : UInt64) (byte : UInt8) : IO UInt64
+
+/-- Map a file read-only. -/
+def openFile (path : System.FilePath) : IO MappedFile := openFFI path.toString
+
+/-- File size in bytes. -/
+def size (mf : MappedFile) : Nat := (sizeFFI mf).toNat
+
+/-- Bytes `[off, off + len)`, clamped to the end of the file. -/
+def read (mf : MappedFile) (off len : Nat) : IO ByteArray :=
+  readFFI mf off.toUInt64 len.toUInt64
+
+/-- Offset of the first `byte` at or after `off`, or the file size. -/
+def findByte (mf : MappedFile) (off : Nat) (byte : UInt8) : IO Nat :=
+  return (← findByteFFI mf off.toUInt64 byte).toNat
+
+end MappedFile
+
+-- ============================================================================
+-- Log files
+-- ============================================================================
+
+/-- A sorted, line-oriented log whose lines start with a timestamp. -/
+structure LogFile where
+  file : MappedFile
+  /-- Reads the timestamp at the head of a line, if it has one. -/
+  parseHead : ByteArray → Option Timestamp
+
+namespace LogFile
+
+/-- Bytes of each line head handed to `parseHead`. -/
+def headBytes : Nat := 64
+
+/-- Parse a leading ISO 8601 date-time ("2024-03-10T14:03:05.123Z ..." or
+    "2024-03-10 14:03:05,123 ..."). The time is read as UTC; zone suffixes
+    are ignored. -/
+def parseIsoHead (head : ByteArray) : Option Timestamp :=
+  -- Date, separator and time, then an optional '.' or ',' fraction
+  let chars := head.toList.map fun b => Char.ofNat b.toNat
+  let base := chars.take 19
+  let frac := (chars.drop 19).take 10
+  let fracDigits :=
+    match frac with
+    | c :: rest => if c == '.' || c == ',' then rest.takeWhile Char.isDigit else []
+    | [] => []
+  let text := String.ofList base ++ (if fracDigits.isEmpty then "" else "." ++ String.ofList fracDigits)
+  if base.length < 19 then none
+  else match DateTime.parseIso8601 text with
+    | .ok dt => some dt.toTimestampPure
+    | .error _ => none
+
+/-- Open a log file. `parseHead` defaults to `parseIsoHead`. -/
+def openFile (path : System.FilePath) (parseHead : ByteArray → Option Timestamp := parseIsoHead) :
+    IO LogFile := do
+  return { file := ← MappedFile.openFile path, parseHead }
+
+/-- File size in bytes. -/
+def size (log : LogFile) : Nat := log.file.size
+
+/-- Start of the line following the one containing `off`. -/
+private def nextLine (log : LogFile) (off : Nat) : IO Nat := do
+  let nl ← log.file.findByte off 10
+  return min log.size (nl + 1)
+
+/-- First line start at or after `off`. -/
+private def lineStartAtOrAfter (log : LogFile) (off : Nat) : IO Nat :=
+  if off == 0 then pure 0 else log.nextLine (off - 1)
+
+/-- Timestamp at the head of the line starting at `off`. -/
+private def headAt (log : LogFile) (off : Nat) : IO (Option Timestamp) := do
+  return log.parseHead (← log.file.read off headBytes)
+
+/-- The first line at or after `off` and before `hi` with a parseable
+    timestamp, with that timestamp. -/
+private partial def firstTimed (log : LogFile) (off hi : Nat) : IO (Option (Nat × Timestamp)) := do
+  if off ≥ hi then return none
+  match ← log.headAt off with
+  | some ts => return some (off, ts)
+  | none => log.firstTimed (← log.nextLine off) hi
+
+/-- Search `[lo, hi)` for the first timed line stamped at or after `t`.
+    `lo` is a line start and timed lines before it are before `t`;
+    `found` is the answer if `[lo, hi)` holds no such line. -/
+private partial def seekIn (log : LogFile) (t : Timestamp) (lo hi found : Nat) : IO Nat := do
+  if lo ≥ hi then return found
+  let s ← log.lineStartAtOrAfter ((lo + hi) / 2)
+  let s := if s ≥ hi then lo else s
+  match ← log.firstTimed s hi with
+  | none =>
+    -- Untimed lines from `s` to `hi` continue an earlier entry
+    if s == lo then return found else log.seekIn t lo s found
+  | some (q, ts) =>
+    if ts < t then log.seekIn t (← log.nextLine q) hi found
+    else log.seekIn t lo q q
+
+/-- Byte offset of the first line stamped at or after `t`, or the file
+    size if there is none. Takes O(log size) line reads. -/
+def seek (log : LogFile) (t : Timestamp) : IO Nat :=
+  log.seekIn t 0 log.size log.size
+
+/-- Byte range `[start, stop)` of the lines stamped in `[t1, t2)`. -/
+def rangeOffsets (log : LogFile) (t1 t2 : Timestamp) : IO (Nat × Nat) := do
+  let start ← log.seek t1
+  let stop ← if t2 ≤ t1 then pure start else log.seek t2
+  return (start, max start stop)
+
+/-- Decode a line, falling back to Latin-1 for invalid UTF-8. -/
+private def decodeLine (b : ByteArray) : String :=
+  match String.fromUTF8? b with
+  | some s => s
+  | none => String.ofList (b.toList.map fun c => Char.ofNat c.toNat)
+
+/-- Bytes `[start, stop)` of a line as a string, without the CR of a
+    CRLF line ending. -/
+private def lineOf (bytes : ByteArray) (start stop : Nat) : String :=
+  let stop := if stop > start && bytes[stop - 1]! == 13 then stop - 1 else stop
+  decodeLine (bytes.extract start stop)
+
+/-- Stream the lines in byte range `[start, stop)` to `f`, reading about
+    `chunkSize` bytes at a time. Line terminators (LF or CRLF) are stripped. -/
+partial def forLinesBetween (log : LogFile) (start stop : Nat) (f : String → IO Unit)
+    (chunkSize : Nat := 65536) : IO Unit := do
+  if start ≥ stop then return
+  -- Extend the chunk to a line end so no line is split
+  let target := min stop (start + chunkSize)
+  let chunkEnd ← if target < stop then pure (min stop (← log.nextLine (target - 1))) else pure stop
+  let bytes ← log.file.read start (chunkEnd - start)
+  let mut lineStart := 0
+  for i in [0:bytes.size] do
+    if bytes[i]! == 10 then
+      f (lineOf bytes lineStart i)
+      lineStart := i + 1
+  if lineStart < bytes.size then
+    f (lineOf bytes lineStart bytes.size)
+  log.forLinesBetween chunkEnd stop f chunkSize
+
+/-- Stream the lines stamped in `[t1, t2)`, with their continuation lines. -/
+def forLinesIn (log : LogFile) (t1 t2 : Timestamp) (f : String → IO Unit) : IO Unit := do
+  let (start, stop) ← log.rangeOffsets t1 t2
+  log.forLinesBetween start stop f
+
+/-- The lines stamped in `[t1, t2)`. Loads the range (not the file) into memory. -/
+def linesIn (log : LogFile) (t1 t2 : Timestamp) : IO (Array String) := do
+  let out ← IO.mkRef (#[] : Array String)
+  log.forLinesIn t1 t2 fun line => out.modify (·.push line)
+  out.get
+
+end LogFile
+
+end Chronos
@@ -0,0 +1,169 @@
+/-
+  Chronos.Range
+  Lazy DateTime ranges with fixed or calendar steps.
+
+  Iteration keeps a single cursor and advances its fields incrementally
+  (nanosecond-of-day with carry, then day-of-month with month carry), so
+  each step costs a few additions instead of a Julian Day round trip, and
+  memory stays constant regardless of the range length.
+-/
+
+import Chronos.DateTime
+
+namespace Chronos
+
+/-- Step between consecutive elements of a `DateTimeRange`. -/
+inductive RangeStep where
+  /-- Fixed elapsed step (e.g. 1 hour, 15 minutes). Must be positive. -/
+  | fixed (d : Duration)
+  /-- Whole calendar days. Must be positive. -/
+  | days (n : Nat)
+  /-- Whole calendar months. Element `k` is `start.addMonthsPure (k * n)`,
+      so clamped days (Jan 31 → Feb 28) do not drift. Must be positive. -/
+  | months (n : Nat)
+  deriving Repr, BEq, Inhabited
+
+/-- A half-open range of DateTimes `[start, stop)` with a step. -/
+structure DateTimeRange where
+  start : DateTime
+  /-- Exclusive upper bound. -/
+  stop : DateTime
+  step : RangeStep
+  deriving Repr, Inhabited
+
+namespace DateTimeRange
+
+private def nanosPerDay : Nat := 86400 * 1000000000
+
+/-- Iteration state for a `DateTimeRange`. -/
+structure Iter where
+  /-- First element, kept as the anchor for month steps. -/
+  anchor : DateTime
+  /-- Next element to yield. -/
+  current : DateTime
+  stop : DateTime
+  /-- Whole days per step (fixed and day steps). -/
+  stepDays : Nat
+  /-- Sub-day nanoseconds per step (fixed steps). -/
+  stepNanos : Nat
+  /-- Months per step (month steps); 0 for the other step kinds. -/
+  stepMonths : Nat
+  /-- Index of `current`, used by month steps. -/
+  index : Nat
+  deriving Repr, Inhabited
+
+-- ============================================================================
+-- Incremental field arithmetic
+-- ============================================================================
+
+/-- Add days by walking the month table; long jumps take a single
+    epoch-day decode instead. -/
+private def advanceDays (dt : DateTime) (n : Nat) : DateTime := Id.run do
+  if n == 0 then return dt
+  if n > 62 then
+    return DateTime.fromEpochDays (dt.toEpochDays + n) dt.hour dt.minute dt.second dt.nanosecond
+  let mut y := dt.year
+  let mut m := dt.month
+  let mut d := dt.day.toNat + n
+  -- With n ≤ 62 at most three month boundaries are crossed
+  for _ in [0:4] do
+    let dim := (DateTime.daysInMonth y m).toNat
+    if d ≤ dim then break
+    d := d - dim
+    if m == 12 then
+      m := 1
+      y := y + 1
+    else
+      m := m + 1
+  return { dt with year := y, month := m, day := UInt8.ofNat d }
+
+/-- Add a sub-day nanosecond step, carrying into whole days. -/
+private def advanceFixed (dt : DateTime) (stepDays stepNanos : Nat) : DateTime :=
+  let nod := dt.secondOfDay * 1000000000 + dt.nanosecond.toNat + stepNanos
+  let carry := nod / nanosPerDay
+  let nod := nod % nanosPerDay
+  let sod := nod / 1000000000
+  let dt := { dt with hour := UInt8.ofNat (sod / 3600), minute := UInt8.ofNat (sod % 3600 / 60),
+                      second := UInt8.ofNat (sod % 60), nanosecond := UInt32.ofNat (nod % 1000000000) }
+  advanceDays dt (stepDays + carry)
+
+namespace Iter
+
+/-- Advance the cursor by one step. -/
+def advance (it : Iter) : Iter :=
+  let index := it.index + 1
+  let current :=
+    if it.stepMonths > 0 then it.anchor.addMonthsPure (index * it.stepMonths)
+    else if it.stepNanos == 0 then advanceDays it.current it.stepDays
+    else advanceFixed it.current it.stepDays it.stepNanos
+  { it with current := current, index := index }
+
+/-- Yield the next element, or `none` once the cursor reaches `stop`. -/
+def next? (it : Iter) : Option (DateTime × Iter) :=
+  if it.current < it.stop then some (it.current, it.advance) else none
+
+instance : Stream Iter DateTime where
+  next? := Iter.next?
+
+end Iter
+
+/-- Start iterating a range. Non-positive steps yield an empty range. -/
+def iter (r : DateTimeRange) : Iter :=
+  let steps : Nat × Nat × Nat :=
+    match r.step with
+    | .fixed d =>
+      if d.nanoseconds ≤ 0 then (0, 0, 0)
+      else
+        let n := d.nanoseconds.toNat
+        (n / nanosPerDay, n % nanosPerDay, 0)
+    | .days n => (n, 0, 0)
+    | .months n => (0, 0, n)
+  let (stepDays, stepNanos, stepMonths) := steps
+  let empty := stepDays == 0 && stepNanos == 0 && stepMonths == 0
+  { anchor := r.start, current := if empty then r.stop else r.start, stop := r.stop,
+    stepDays, stepNanos, stepMonths, index := 0 }
+
+instance : ToStream DateTimeRange Iter where
+  toStream := iter
+
+instance : ForIn m DateTimeRange DateTime where
+  forIn r b f := forIn r.iter b f
+
+/-- Materialize the range (for small ranges and tests). -/
+def toArray (r : DateTimeRange) : Array DateTime := Id.run do
+  let mut out : Array DateTime := #[]
+  for dt in r do
+    out := out.push dt
+  return out
+
+-- ============================================================================
+-- Constructors
+-- ============================================================================
+
+/-- Every `n` calendar days in `[start, stop)`. -/
+def daily (start stop : DateTime) (n : Nat := 1) : DateTimeRange :=
+  { start, stop, step := .days n }
+
+/-- Every `n` hours in `[start, stop)`. -/
+def hourly (start stop : DateTime) (n : Nat := 1) : DateTimeRange :=
+  { start, stop, step := .fixed (Duration.fromHours n) }
+
+/-- Every `n` calendar months in `[start, stop)`. -/
+def monthly (start stop : DateTime) (n : Nat := 1) : DateTimeRange :=
+  { start, stop, step := .months n }
+
+/-- Every `d` of elapsed time in `[start, stop)`. -/
+def every (start stop : DateTime) (d : Duration) : DateTimeRange :=
+  { start, stop, step := .fixed d }
+
+end DateTimeRange
+
+namespace DateTime
+
+/-- A lazy range `[start, stop)` with the given step. -/
+def range (start stop : DateTime) (step : RangeStep) : DateTimeRange :=
+  { start, stop, step }
+
+end DateTime
+
+end Chronos
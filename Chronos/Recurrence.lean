@@ -0,0 +1,415 @@
+/-
+  Chronos.Recurrence
+  RFC 5545 recurrence rules (RRULE) with lazy expansion.
+
+  Supported parts: FREQ (DAILY/WEEKLY/MONTHLY/YEARLY), INTERVAL, BYDAY
+  (with optional ordinals such as `-1FR`), BYMONTHDAY, BYMONTH, COUNT,
+  UNTIL and WKST=MO. Rules are expanded on wall-clock `DateTime`s one
+  period at a time, so only the occurrences of the current period are
+  ever materialized. Seeking to an arbitrary time computes the period
+  index directly instead of walking from DTSTART.
+-/
+
+import Chronos.DateTime
+
+namespace Chronos
+
+open DateTime (Weekday)
+
+/-- Recurrence frequency (the FREQ part). -/
+inductive Frequency where
+  | daily
+  | weekly
+  | monthly
+  | yearly
+  deriving Repr, BEq, Inhabited, DecidableEq
+
+/-- A BYDAY entry: a weekday with an optional ordinal within the month or
+    year (1 = first, -1 = last). -/
+structure ByDay where
+  weekday : Weekday
+  ordinal : Option Int := none
+  deriving Repr, BEq, Inhabited
+
+/-- A parsed recurrence rule. -/
+structure RRule where
+  freq : Frequency
+  /-- Number of periods between occurrences (at least 1). -/
+  interval : Nat := 1
+  byDay : Array ByDay := #[]
+  /-- Days of the month; negative values count from the end (-1 = last day). -/
+  byMonthDay : Array Int := #[]
+  /-- Months of the year [1, 12]. -/
+  byMonth : Array Nat := #[]
+  /-- Maximum number of occurrences. -/
+  count : Option Nat := none
+  /-- Last allowed occurrence (inclusive). -/
+  «until» : Option DateTime := none
+  /-- Whether `until` is a UTC time (`Z` suffix) rather than wall-clock time. -/
+  untilUtc : Bool := false
+  deriving Repr, BEq, Inhabited
+
+namespace RRule
+
+-- ============================================================================
+-- Parsing
+-- ============================================================================
+
+/-- Parse a fixed-width run of digits from a character list. -/
+private def digitsAt (cs : List Char) (start count : Nat) : Option Nat :=
+  let seg := (cs.drop start).take count
+  if seg.length == count && seg.all Char.isDigit then
+    some (seg.foldl (fun acc c => acc * 10 + (c.toNat - '0'.toNat)) 0)
+  else none
+
+/-- Parse an integer with an optional leading `+` or `-`. -/
+private def parseSigned (s : String) : Option Int :=
+  match s.trim.toList with
+  | '-' :: rest => (String.ofList rest).toNat?.map fun n => -(n : Int)
+  | '+' :: rest => (String.ofList rest).toNat?.map fun n => (n : Int)
+  | rest => (String.ofList rest).toNat?.map fun n => (n : Int)
+
+private def parseFreq (v : String) : DateTime.ParseResult Frequency :=
+  match v.toUpper with
+  | "DAILY" => .ok .daily
+  | "WEEKLY" => .ok .weekly
+  | "MONTHLY" => .ok .monthly
+  | "YEARLY" => .ok .yearly
+  | other => .error s!"unsupported FREQ: {other}"
+
+private def parseWeekdayCode (code : String) : Option Weekday :=
+  match code with
+  | "SU" => some .sunday
+  | "MO" => some .monday
+  | "TU" => some .tuesday
+  | "WE" => some .wednesday
+  | "TH" => some .thursday
+  | "FR" => some .friday
+  | "SA" => some .saturday
+  | _ => none
+
+private def parseByDay (tok : String) : DateTime.ParseResult ByDay := do
+  let cs := tok.trim.toUpper.toList
+  if cs.length < 2 then throw s!"invalid BYDAY entry: {tok}"
+  let some weekday := parseWeekdayCode (String.ofList (cs.drop (cs.length - 2)))
+    | throw s!"invalid BYDAY weekday: {tok}"
+  let pre := cs.take (cs.length - 2)
+  if pre.isEmpty then return { weekday }
+  match parseSigned (String.ofList pre) with
+  | some n =>
+    if n == 0 || n.natAbs > 53 then throw s!"invalid BYDAY ordinal: {tok}"
+    return { weekday, ordinal := some n }
+  | none => throw s!"invalid BYDAY ordinal: {tok}"
+
+/-- Parse UNTIL as `YYYYMMDD` or `YYYYMMDDTHHMMSS[Z]`. -/
+private def parseUntil (v : String) : DateTime.ParseResult (DateTime × Bool) := do
+  let cs := v.trim.toList
+  let utc := cs.getLast? == some 'Z'
+  let cs := if utc then cs.dropLast else cs
+  let some year := digitsAt cs 0 4 | throw s!"invalid UNTIL: {v}"
+  let some month := digitsAt cs 4 2 | throw s!"invalid UNTIL: {v}"
+  let some day := digitsAt cs 6 2 | throw s!"invalid UNTIL: {v}"
+  let (hour, minute, second) ←
+    if cs.length == 8 then pure (0, 0, 0)
+    else if cs.length == 15 && cs[8]? == some 'T' then
+      match digitsAt cs 9 2, digitsAt cs 11 2, digitsAt cs 13 2 with
+      | some h, some mi, some s => pure (h, mi, s)
+      | _, _, _ => throw s!"invalid UNTIL time: {v}"
+    else throw s!"invalid UNTIL: {v}"
+  match DateTime.mk? (Int.toInt32 year) (UInt8.ofNat month) (UInt8.ofNat day)
+      (UInt8.ofNat hour) (UInt8.ofNat minute) (UInt8.ofNat second) with
+  | some dt => return (dt, utc)
+  | none => throw s!"invalid UNTIL: {v}"
+
+/-- Parse an RRULE value such as `FREQ=WEEKLY;INTERVAL=2;BYDAY=MO,WE;COUNT=10`.
+    A leading `RRULE:` property name is accepted. -/
+def parse (s : String) : DateTime.ParseResult RRule := do
+  let s := s.trim
+  let body := if s.startsWith "RRULE:" then String.ofList (s.toList.drop 6) else s
+  let mut freq : Option Frequency := none
+  let mut rule : RRule := { freq := .daily }
+  for part in body.splitOn ";" do
+    if part.isEmpty then continue
+    match part.splitOn "=" with
+    | [key, value] =>
+      match key.toUpper with
+      | "FREQ" =>
+        let f ← parseFreq value
+        freq := some f
+      | "INTERVAL" =>
+        match value.toNat? with
+        | some n => if n == 0 then throw "INTERVAL must be positive" else rule := { rule with interval := n }
+        | none => throw s!"invalid INTERVAL: {value}"
+      | "COUNT" =>
+        match value.toNat? with
+        | some n => rule := { rule with count := some n }
+        | none => throw s!"invalid COUNT: {value}"
+      | "UNTIL" =>
+        let (u, utc) ← parseUntil value
+        rule := { rule with «until» := some u, untilUtc := utc }
+      | "BYDAY" =>
+        let days ← (value.splitOn ",").toArray.mapM parseByDay
+        rule := { rule with byDay := days }
+      | "BYMONTHDAY" =>
+        let days ← (value.splitOn ",").toArray.mapM fun v =>
+          match parseSigned v with
+          | some d => if d == 0 || d.natAbs > 31 then throw s!"invalid BYMONTHDAY: {v}" else pure d
+          | none => throw s!"invalid BYMONTHDAY: {v}"
+        rule := { rule with byMonthDay := days }
+      | "BYMONTH" =>
+        let months ← (value.splitOn ",").toArray.mapM fun v =>
+          match v.trim.toNat? with
+          | some m => if m < 1 || m > 12 then throw s!"invalid BYMONTH: {v}" else pure m
+          | none => throw s!"invalid BYMONTH: {v}"
+        rule := { rule with byMonth := months }
+      | "WKST" =>
+        if value.toUpper != "MO" then throw s!"unsupported WKST: {value}"
+      | other => throw s!"unsupported RRULE part: {other}"
+    | _ => throw s!"malformed RRULE part: {part}"
+  if rule.count.isSome && rule.«until».isSome then
+    throw "COUNT and UNTIL are mutually exclusive"
+  match freq with
+  | some f => return { rule with freq := f }
+  | none => throw "missing FREQ"
+
+-- ============================================================================
+-- Period expansion
+-- ============================================================================
+
+private def sortDedup (xs : Array Nat) : Array Nat :=
+  (xs.qsort (· < ·)).foldl (init := (#[] : Array Nat)) fun acc x =>
+    if acc.back? == some x then acc else acc.push x
+
+/-- Positions [1, len] in a span (month or year) whose first day has weekday
+    `firstWd` that match the BYDAY entries, honoring ordinals. -/
+private def spanWeekdays (byDay : Array ByDay) (len firstWd : Nat) : Array Nat := Id.run do
+  let mut out : Array Nat := #[]
+  for bd in byDay do
+    let d1 := 1 + (bd.weekday.toNat + 7 - firstWd) % 7
+    let last := d1 + 7 * ((len - d1) / 7)
+    match bd.ordinal with
+    | none =>
+      for k in [0:(last - d1) / 7 + 1] do
+        out := out.push (d1 + 7 * k)
+    | some n =>
+      if n > 0 then
+        let d := d1 + 7 * (n.toNat - 1)
+        if d ≤ len then out := out.push d
+      else
+        let back := 7 * (n.natAbs - 1)
+        if back < last then out := out.push (last - back)
+  return out
+
+/-- Days of month `m` selected by BYMONTHDAY and BYDAY, or `defaultDay` when
+    neither is given (skipped if the month is too short, per RFC 5545). -/
+private def monthDays (r : RRule) (y : Int) (m : Nat) (defaultDay : Nat) : Array Nat :=
+  let dim := (DateTime.daysInMonth (Int.toInt32 y) (UInt8.ofNat m)).toNat
+  let byMonthDay := r.byMonthDay.filterMap fun md =>
+    let d : Int := if md > 0 then md else (dim : Int) + 1 + md
+    if 1 ≤ d && d ≤ dim then some d.toNat else none
+  let firstWd := (DateTime.weekdayOfEpochDays (DateTime.daysFromCivil y m 1)).toNat
+  let byDay := spanWeekdays r.byDay dim firstWd
+  if r.byMonthDay.isEmpty && r.byDay.isEmpty then
+    if defaultDay ≤ dim then #[defaultDay] else #[]
+  else if r.byDay.isEmpty then sortDedup byMonthDay
+  else if r.byMonthDay.isEmpty then sortDedup byDay
+  else sortDedup (byMonthDay.filter byDay.contains)
+
+/-- Whether a single day passes the BYMONTH/BYMONTHDAY/BYDAY filters
+    (used for DAILY rules, where BY parts only limit). -/
+private def dayMatches (r : RRule) (day : Int) : Bool :=
+  let wdOk := r.byDay.isEmpty ||
+    r.byDay.any (·.weekday == DateTime.weekdayOfEpochDays day)
+  if r.byMonth.isEmpty && r.byMonthDay.isEmpty then wdOk
+  else
+    let (y, m, d) := DateTime.civilFromDays day
+    let dim := (DateTime.daysInMonth (Int.toInt32 y) (UInt8.ofNat m)).toNat
+    wdOk && (r.byMonth.isEmpty || r.byMonth.contains m) &&
+      (r.byMonthDay.isEmpty || r.byMonthDay.any fun md =>
+        if md > 0 then md == (d : Int) else (dim : Int) + 1 + md == (d : Int))
+
+/-- Monday of the ISO week containing `day`. -/
+private def mondayOf (day : Int) : Int := day - (day + 3).fmod 7
+
+/-- Candidate days (since 1970-01-01) of period `p`, in ascending order. -/
+private def periodDays (r : RRule) (start : DateTime) (p : Nat) : Array Int :=
+  let startDay := start.toEpochDays
+  let step := p * max 1 r.interval
+  match r.freq with
+  | .daily =>
+    let d := startDay + step
+    if dayMatches r d then #[d] else #[]
+  | .weekly =>
+    let wds := if r.byDay.isEmpty then #[start.weekdayPure.toNat] else r.byDay.map (·.weekday.toNat)
+    let monday := mondayOf startDay + 7 * step
+    let days := (sortDedup (wds.map fun w => (w + 6) % 7)).map fun o => monday + o
+    if r.byMonth.isEmpty then days
+    else days.filter fun d => r.byMonth.contains (DateTime.civilFromDays d).2.1
+  | .monthly =>
+    let mi := start.year.toInt * 12 + (start.month.toNat - 1 : Nat) + step
+    let y := mi.fdiv 12
+    let m := (mi.fmod 12).toNat + 1
+    if !r.byMonth.isEmpty && !r.byMonth.contains m then #[]
+    else (monthDays r y m start.day.toNat).map fun d => DateTime.daysFromCivil y m d
+  | .yearly =>
+    let y := start.year.toInt + step
+    if r.byMonth.isEmpty && r.byMonthDay.isEmpty && !r.byDay.isEmpty then
+      -- Year-relative BYDAY, e.g. 20MO = 20th Monday of the year
+      let jan1 := DateTime.daysFromCivil y 1 1
+      let len := if DateTime.isLeapYear (Int.toInt32 y) then 366 else 365
+      let firstWd := (DateTime.weekdayOfEpochDays jan1).toNat
+      (sortDedup (spanWeekdays r.byDay len firstWd)).map fun doy => jan1 + doy - 1
+    else
+      let months :=
+        if !r.byMonth.isEmpty then sortDedup r.byMonth
+        else if !r.byMonthDay.isEmpty then (Array.range 12).map (· + 1)
+        else #[start.month.toNat]
+      months.foldl (init := (#[] : Array Int)) fun acc m =>
+        acc ++ (monthDays r y m start.day.toNat).map fun d => DateTime.daysFromCivil y m d
+
+/-- Occurrences of period `p` at DTSTART's time of day, excluding any before DTSTART. -/
+private def expand (r : RRule) (start : DateTime) (p : Nat) : Array DateTime :=
+  (periodDays r start p).filterMap fun d =>
+    let dt := DateTime.fromEpochDays d start.hour start.minute start.second start.nanosecond
+    if start ≤ dt then some dt else none
+
+/-- Occurrences per period when it is the same for every period after the
+    first, which lets COUNT bookkeeping skip ahead arithmetically. -/
+private def perPeriod? (r : RRule) : Option Nat :=
+  if !r.byMonth.isEmpty || !r.byMonthDay.isEmpty then none
+  else match r.freq with
+    | .daily => if r.byDay.isEmpty then some 1 else none
+    | .weekly =>
+      if r.byDay.isEmpty then some 1
+      else some (sortDedup (r.byDay.map (·.weekday.toNat))).size
+    | _ => none
+
+end RRule
+
+-- ============================================================================
+-- Lazy iteration
+-- ============================================================================
+
+/-- Lazy iterator over the occurrences of a rule. Holds only the current
+    period's occurrences. -/
+structure RecurrenceIter where
+  rule : RRule
+  /-- DTSTART, as wall-clock time. -/
+  start : DateTime
+  /-- Index of the next period to expand. -/
+  period : Nat := 0
+  /-- Occurrences of the last expanded period. -/
+  pending : Array DateTime := #[]
+  /-- Position of the next occurrence in `pending`. -/
+  pos : Nat := 0
+  /-- Occurrences yielded (or skipped by seeking) so far, for COUNT. -/
+  emitted : Nat := 0
+  deriving Repr, Inhabited
+
+namespace RecurrenceIter
+
+/-- Upper bound on consecutive empty periods before the rule is considered
+    exhausted (e.g. BYMONTH=2;BYMONTHDAY=30 never matches). -/
+private def maxEmptyPeriods : Nat := 10000
+
+/-- Yield the next occurrence, or `none` when the rule is exhausted. -/
+def next? (it : RecurrenceIter) : Option (DateTime × RecurrenceIter) := Id.run do
+  if let some c := it.rule.count then
+    if it.emitted ≥ c then return none
+  let mut it := it
+  for _ in [0:maxEmptyPeriods] do
+    if h : it.pos < it.pending.size then
+      let dt := it.pending[it.pos]
+      if let some u := it.rule.«until» then
+        if u < dt then return none
+      return some (dt, { it with pos := it.pos + 1, emitted := it.emitted + 1 })
+    it := { it with pending := RRule.expand it.rule it.start it.period,
+                    pos := 0, period := it.period + 1 }
+  return none
+
+instance : Stream RecurrenceIter DateTime where
+  next? := RecurrenceIter.next?
+
+/-- Collect up to `n` further occurrences. -/
+def take (it : RecurrenceIter) (n : Nat) : Array DateTime := Id.run do
+  let mut it := it
+  let mut out : Array DateTime := Array.mkEmpty n
+  for _ in [0:n] do
+    match it.next? with
+    | some (dt, it') =>
+      out := out.push dt
+      it := it'
+    | none => break
+  return out
+
+end RecurrenceIter
+
+namespace RRule
+
+/-- Iterate a rule from DTSTART (wall-clock time). -/
+def iter (r : RRule) (start : DateTime) : RecurrenceIter :=
+  { rule := r, start }
+
+/-- Iterate a rule starting at its first occurrence at or after `t`.
+    The period containing `t` is computed directly from the frequency and
+    interval. With COUNT, the occurrences before that period are counted
+    arithmetically when every period has the same size (plain DAILY, WEEKLY);
+    otherwise the skipped periods are expanded to count them. -/
+def iterFrom (r : RRule) (start : DateTime) (t : DateTime) : RecurrenceIter :=
+  if t ≤ start then r.iter start
+  else
+    let n : Int := max 1 r.interval
+    let diff : Int := match r.freq with
+      | .daily => t.toEpochDays - start.toEpochDays
+      | .weekly => (mondayOf t.toEpochDays - mondayOf start.toEpochDays) / 7
+      | .monthly => (t.year.toInt * 12 + t.month.toNat) - (start.year.toInt * 12 + start.month.toNat)
+      | .yearly => t.year.toInt - start.year.toInt
+    let p := (diff.fdiv n).toNat
+    let before : Nat :=
+      if r.count.isNone || p == 0 then 0
+      else match perPeriod? r with
+        | some k => (expand r start 0).size + (p - 1) * k
+        | none => (List.range p).foldl (fun acc q => acc + (expand r start q).size) 0
+    let pending := expand r start p
+    let skip := (pending.findIdx? fun dt => t ≤ dt).getD pending.size
+    { rule := r, start, period := p + 1, pending, pos := skip, emitted := before + skip }
+
+/-- Convert a UTC UNTIL to wall-clock time in `tz`, so the rule can be
+    expanded purely in that zone. -/
+def localize (r : RRule) (tz : Timezone) : IO RRule := do
+  match r.«until» with
+  | some u =>
+    if r.untilUtc then
+      let wall ← DateTime.fromTimestampInTimezone u.toTimestampPure tz
+      return { r with «until» := some wall, untilUtc := false }
+    else return r
+  | none => return r
+
+/-- Iterate a rule whose DTSTART is wall-clock time in `tz`. -/
+def iterInTimezone (r : RRule) (start : DateTime) (tz : Timezone) : IO RecurrenceIter := do
+  let r ← r.localize tz
+  return r.iter start
+
+/-- Iterate a rule in `tz` from its first occurrence at or after the instant `after`. -/
+def iterAfterInstant (r : RRule) (start : DateTime) (tz : Timezone) (after : Timestamp) :
+    IO RecurrenceIter := do
+  let r ← r.localize tz
+  let t ← DateTime.fromTimestampInTimezone after tz
+  return r.iterFrom start t
+
+end RRule
+
+namespace RecurrenceIter
+
+/-- Yield the next occurrence together with its instant in `tz`. -/
+def nextInstant (it : RecurrenceIter) (tz : Timezone) :
+    IO (Option (DateTime × Timestamp × RecurrenceIter)) := do
+  match it.next? with
+  | some (dt, it') =>
+    let ts ← dt.toTimestampInTimezone tz
+    return some (dt, ts, it')
+  | none => return none
+
+end RecurrenceIter
+
+end Chronos
@@ -0,0 +1,195 @@
+/-
+  Chronos.Resample
+  Downsampling of sorted time series to fixed-width bins, with gap filling.
+
+  Samples are consumed one at a time and only the open bin's
+  accumulators are kept, so the same `Resampler` serves whole arrays
+  and unbounded streams. A bin is emitted as soon as a sample lands in
+  a later bin; empty bins in between are filled from the samples on
+  either side of the gap. Bins are aligned like `Bucket.bin`.
+-/
+
+import Chronos.Bucket
+
+namespace Chronos
+
+/-- How the samples in one bin are combined. -/
+inductive Aggregation where
+  | first
+  | last
+  | mean
+  | min
+  | max
+  | sum
+  | count
+  /-- Mean of the step function through the samples (each value holds
+      until the next sample), weighted by how long each value lasted
+      inside the bin. The value before the bin's first sample is carried
+      in from the previous sample. -/
+  | timeWeighted
+  deriving Repr, BEq, Inhabited, DecidableEq
+
+/-- Value given to bins that contain no samples. -/
+inductive FillPolicy where
+  /-- The last sample before the bin (sample and hold). -/
+  | previous
+  /-- Linear interpolation between the samples around the gap, at the
+      bin start. -/
+  | linear
+  /-- No value. -/
+  | null
+  deriving Repr, BEq, Inhabited, DecidableEq
+
+/-- Streaming resampler state. Feed samples in time order with `push` and
+    end the series with `finish`. Samples that fall before the open bin
+    are dropped and counted. -/
+structure Resampler where
+  width : Duration
+  origin : Timestamp
+  aggregation : Aggregation
+  fill : FillPolicy
+  /-- Start of the open bin; `none` before the first sample. -/
+  bin : Option Timestamp := none
+  /-- Samples in the open bin. -/
+  count : Nat := 0
+  first : Float := 0
+  sum : Float := 0
+  lo : Float := 0
+  hi : Float := 0
+  /-- Time-weighted area (value × seconds) and seconds covered so far in
+      the open bin, up to `lastTime`. -/
+  area : Float := 0
+  covered : Float := 0
+  /-- Latest sample. -/
+  lastTime : Timestamp := Timestamp.epoch
+  lastValue : Float := 0
+  /-- Samples ignored because they fell before the open bin. -/
+  dropped : Nat := 0
+  deriving Repr, Inhabited
+
+namespace Resampler
+
+/-- A resampler into bins of `width` aligned on `origin`, or `none` if
+    `width` is not positive. -/
+def new (width : Duration) (aggregation : Aggregation) (fill : FillPolicy := .null)
+    (origin : Timestamp := Timestamp.epoch) : Option Resampler :=
+  if width.isPositive then some { width, origin, aggregation, fill } else none
+
+/-- Signed seconds from `a` to `b`. -/
+private def secondsBetween (a b : Timestamp) : Float :=
+  Float.ofInt (b.seconds - a.seconds) + (b.nanoseconds.toFloat - a.nanoseconds.toFloat) / 1e9
+
+/-- Aggregate of the open bin, closing it at `stop`. -/
+private def value (r : Resampler) (stop : Timestamp) : Float :=
+  match r.aggregation with
+  | .first => r.first
+  | .last => r.lastValue
+  | .mean => r.sum / r.count.toFloat
+  | .min => r.lo
+  | .max => r.hi
+  | .sum => r.sum
+  | .count => r.count.toFloat
+  | .timeWeighted =>
+    let tail := secondsBetween r.lastTime stop
+    (r.area + r.lastValue * tail) / (r.covered + tail)
+
+/-- Fill value for the empty bin starting at `t`, between the latest
+    sample and the next one (if known). -/
+private def fillAt (r : Resampler) (t : Timestamp) (next : Option (Timestamp × Float)) :
+    Option Float :=
+  match r.fill with
+  | .null => none
+  | .previous => some r.lastValue
+  | .linear =>
+    next.map fun (nt, nv) =>
+      let span := secondsBetween r.lastTime nt
+      if span > 0 then
+        r.lastValue + (nv - r.lastValue) * (secondsBetween r.lastTime t / span)
+      else nv
+
+/-- Emit the open bin starting at `start` and the empty bins after it,
+    up to (not including) `untilBin`. -/
+private def closeBins (r : Resampler) (start : Timestamp) (untilBin : Option Timestamp)
+    (next : Option (Timestamp × Float)) (out : Array (Timestamp × Option Float)) :
+    Array (Timestamp × Option Float) := Id.run do
+  let stop := start + r.width
+  let mut out := out.push (start, some (r.value stop))
+  if let some u := untilBin then
+    let mut g := stop
+    while g < u do
+      out := out.push (g, r.fillAt g next)
+      g := g + r.width
+  return out
+
+/-- Add one sample, appending any bins it completes to `out`. -/
+def pushInto (r : Resampler) (t : Timestamp) (v : Float)
+    (out : Array (Timestamp × Option Float)) : Resampler × Array (Timestamp × Option Float) :=
+  let b := Bucket.bin r.width r.origin t
+  match r.bin with
+  | none =>
+    ({ r with bin := some b, count := 1, first := v, sum := v, lo := v, hi := v,
+              area := 0, covered := 0, lastTime := t, lastValue := v }, out)
+  | some cur =>
+    if b < cur then ({ r with dropped := r.dropped + 1 }, out)
+    else if b == cur then
+      let dt := secondsBetween r.lastTime t
+      ({ r with count := r.count + 1, sum := r.sum + v,
+                lo := if v < r.lo then v else r.lo, hi := if v > r.hi then v else r.hi,
+                area := r.area + r.lastValue * dt, covered := r.covered + dt,
+                lastTime := t, lastValue := v }, out)
+    else
+      let out := r.closeBins cur (some b) (some (t, v)) out
+      -- The previous value holds from the new bin's start to this sample
+      let lead := secondsBetween b t
+      ({ r with bin := some b, count := 1, first := v, sum := v, lo := v, hi := v,
+                area := r.lastValue * lead, covered := lead,
+                lastTime := t, lastValue := v }, out)
+
+/-- Add one sample, returning the bins it completes. -/
+def push (r : Resampler) (t : Timestamp) (v : Float) :
+    Resampler × Array (Timestamp × Option Float) :=
+  r.pushInto t v #[]
+
+/-- Emit the open bin, then empty bins up to `stop` (exclusive) if given.
+    Trailing empty bins have no later sample, so `linear` leaves them
+    without a value. -/
+def finish (r : Resampler) (stop : Option Timestamp := none) : Array (Timestamp × Option Float) :=
+  match r.bin with
+  | none => #[]
+  | some cur => r.closeBins cur stop none #[]
+
+end Resampler
+
+namespace Resample
+
+/-- Resample sorted timestamp and value columns (paired by index) in one
+    pass. Bins run from the first sample's bin to the last sample's bin.
+    Returns an empty array when `width` is not positive. -/
+def columns (times : Array Timestamp) (values : Array Float) (width : Duration)
+    (aggregation : Aggregation) (fill : FillPolicy := .null)
+    (origin : Timestamp := Timestamp.epoch) : Array (Timestamp × Option Float) := Id.run do
+  let some r := Resampler.new width aggregation fill origin | return #[]
+  let mut r := r
+  let mut out : Array (Timestamp × Option Float) := #[]
+  for i in [0:min times.size values.size] do
+    let (r', o) := r.pushInto times[i]! values[i]! out
+    r := r'
+    out := o
+  return out ++ r.finish
+
+/-- Resample sorted (timestamp, value) pairs. See `columns`. -/
+def samples (xs : Array (Timestamp × Float)) (width : Duration) (aggregation : Aggregation)
+    (fill : FillPolicy := .null) (origin : Timestamp := Timestamp.epoch) :
+    Array (Timestamp × Option Float) := Id.run do
+  let some r := Resampler.new width aggregation fill origin | return #[]
+  let mut r := r
+  let mut out : Array (Timestamp × Option Float) := #[]
+  for (t, v) in xs do
+    let (r', o) := r.pushInto t v out
+    r := r'
+    out := o
+  return out ++ r.finish
+
+end Resample
+
+end Chronos
@@ -0,0 +1,267 @@
+/-
+  Chronos.Segment
+  Append-only, time-indexed segment files.
+
+  A segment is a 64-byte header followed by fixed-size blocks. Each block
+  starts with a header holding its record count and first and last
+  timestamps, then fixed-width records (int64 nanoseconds, payload offset,
+  payload length), then the payload bytes. Because blocks sit at fixed
+  offsets, their headers form a sparse index: the reader memory-maps the
+  file and binary-searches block headers, then records, so seeking to a
+  timestamp is O(log n) and nothing is parsed up front.
+
+  Timestamps must be non-decreasing. The writer buffers one block in
+  memory and appends it whole, so a crash loses at most the unflushed
+  block and never leaves a partial one visible to readers. Reopening a
+  file for writing cuts off any torn block first.
+-/
+
+import Chronos.Timestamp
+
+namespace Chronos
+
+/-- One timestamped event. -/
+structure SegmentRecord where
+  time : Timestamp
+  payload : ByteArray
+  deriving Inhabited
+
+/-- Position of a record: block index and record index within the block. -/
+structure SegmentCursor where
+  block : UInt64
+  record : UInt32
+  deriving Repr, BEq, Inhabited
+
+namespace Segment
+
+/-- Size of the file header in bytes. -/
+def headerSize : Nat := 64
+/-- Size of a block header in bytes. -/
+def blockHeaderSize : Nat := 32
+/-- Size of one record entry in bytes. -/
+def recordSize : Nat := 16
+/-- Default block size (64 KiB). -/
+def defaultBlockSize : Nat := 65536
+
+/-- Nanoseconds as stored on disk (int64). -/
+private def nanosOf (ts : Timestamp) : Int := ts.toNanoseconds
+
+/-- Largest and smallest nanosecond values the file format can hold. -/
+def maxNs : Int := 9223372036854775807
+def minNs : Int := -9223372036854775808
+
+/-- Clamp nanoseconds into the on-disk range. -/
+def clampNs (ns : Int) : Int := max minNs (min maxNs ns)
+
+private def pushLE (b : ByteArray) (v : Nat) (bytes : Nat) : ByteArray := Id.run do
+  let mut b := b
+  let mut v := v
+  for _ in [0:bytes] do
+    b := b.push (v % 256).toUInt8
+    v := v / 256
+  return b
+
+/-- Two's-complement encoding of a signed 64-bit value. -/
+private def pushI64 (b : ByteArray) (v : Int) : ByteArray :=
+  pushLE b (v % (2 ^ 64 : Int)).toNat 8
+
+/-- The file header for a given block size. -/
+def encodeHeader (blockSize : Nat) : ByteArray :=
+  let b := "CHRSEG01".toUTF8
+  let b := pushLE b 1 4
+  let b := pushLE b blockSize 4
+  b ++ ByteArray.mk (Array.replicate (headerSize - b.size) 0)
+
+/-- Encode one block of records, padded to `blockSize`. The records must
+    fit (see `SegmentWriter.append`). -/
+def encodeBlock (blockSize : Nat) (records : Array (Int × ByteArray)) : ByteArray := Id.run do
+  let first := (records[0]?.map (·.1)).getD 0
+  let last := (records.back?.map (·.1)).getD 0
+  let payloadBytes := records.foldl (fun n (_, p) => n + p.size) 0
+  let mut b := pushLE ByteArray.empty 0x4B424353 4
+  b := pushLE b records.size 4
+  b := pushI64 b first
+  b := pushI64 b last
+  b := pushLE b payloadBytes 4
+  b := pushLE b 0 4
+  let mut off := blockHeaderSize + records.size * recordSize
+  for (ns, p) in records do
+    b := pushI64 b ns
+    b := pushLE b off 4
+    b := pushLE b p.size 4
+    off := off + p.size
+  for (_, p) in records do
+    b := b ++ p
+  return b ++ ByteArray.mk (Array.replicate (blockSize - b.size) 0)
+
+end Segment
+
+-- ============================================================================
+-- Reader
+-- ============================================================================
+
+/-- Opaque handle to a memory-mapped segment file. -/
+opaque SegmentReaderPointed : NonemptyType
+def SegmentReader := SegmentReaderPointed.type
+instance : Nonempty SegmentReader := SegmentReaderPointed.property
+
+namespace SegmentReader
+
+@[extern "chronos_segment_open"]
+private opaque openFFI (path : @& String) : IO SegmentReader
+
+@[extern "chronos_segment_info"]
+private opaque infoFFI (r : @& SegmentReader) : IO (UInt32 × UInt64)
+
+@[extern "chronos_segment_bounds"]
+private opaque boundsFFI (r : @& SegmentReader) : IO (Option (Int × Int))
+
+@[extern "chronos_segment_seek"]
+private opaque seekFFI (r : @& SegmentReader) (ns : @& Int) : IO (UInt64 × UInt32)
+
+@[extern "chronos_segment_read"]
+private opaque readFFI (r : @& SegmentReader) (block : UInt64) (record : UInt32) (max : UInt32)
+  (stop : @& Int) : IO (Array (Int × ByteArray) × (UInt64 × UInt32))
+
+/-- Map a segment file. Blocks appended later are not visible until the
+    file is opened again. -/
+def openFile (path : System.FilePath) : IO SegmentReader := openFFI path.toString
+
+/-- Block size of the file in bytes. -/
+def blockSize (r : SegmentReader) : IO Nat := return (← infoFFI r).1.toNat
+
+/-- Number of readable blocks. -/
+def blockCount (r : SegmentReader) : IO Nat := return (← infoFFI r).2.toNat
+
+/-- Timestamps of the first and last records, if any. -/
+def bounds (r : SegmentReader) : IO (Option (Timestamp × Timestamp)) := do
+  return (← boundsFFI r).map fun (a, b) => (Timestamp.fromNanoseconds a, Timestamp.fromNanoseconds b)
+
+/-- Cursor at the first record at or after `ts` (O(log n)). -/
+def seek (r : SegmentReader) (ts : Timestamp) : IO SegmentCursor := do
+  let (block, record) ← seekFFI r (Segment.clampNs ts.toNanoseconds)
+  return { block, record }
+
+/-- Read up to `max` records from `c`, stopping before `stop` if given.
+    Returns the records and the cursor after them. -/
+def read (r : SegmentReader) (c : SegmentCursor) (max : Nat := 1024) (stop : Option Timestamp := none) :
+    IO (Array SegmentRecord × SegmentCursor) := do
+  let stopNs := (stop.map (Segment.clampNs ·.toNanoseconds)).getD Segment.maxNs
+  let (recs, (block, record)) ← readFFI r c.block c.record max.toUInt32 stopNs
+  return (recs.map fun (ns, payload) => { time := Timestamp.fromNanoseconds ns, payload },
+    { block, record })
+
+/-- All records in `[t1, t2)`, in order. -/
+def range (r : SegmentReader) (t1 t2 : Timestamp) : IO (Array SegmentRecord) := do
+  let mut out : Array SegmentRecord := #[]
+  let mut c ← r.seek t1
+  repeat
+    let (recs, c') ← r.read c 4096 (some t2)
+    out := out ++ recs
+    if recs.size < 4096 then break
+    c := c'
+  return out
+
+/-- All records at or after `ts`, in order. -/
+def since (r : SegmentReader) (ts : Timestamp) : IO (Array SegmentRecord) := do
+  let mut out : Array SegmentRecord := #[]
+  let mut c ← r.seek ts
+  repeat
+    let (recs, c') ← r.read c 4096
+    out := out ++ recs
+    if recs.size < 4096 then break
+    c := c'
+  return out
+
+end SegmentReader
+
+-- ============================================================================
+-- Writer
+-- ============================================================================
+
+/-- Buffered state of an open writer. -/
+structure SegmentWriterState where
+  /-- Records of the block being filled, as (nanoseconds, payload). -/
+  pending : Array (Int × ByteArray) := #[]
+  /-- Bytes the pending block uses so far (header, records, payloads). -/
+  used : Nat := Segment.blockHeaderSize
+  /-- Nanoseconds of the last record appended, if any. -/
+  lastNs : Option Int := none
+
+/-- Appends records to a segment file, one whole block at a time. -/
+structure SegmentWriter where
+  /-- The open file; `none` once the writer is closed. -/
+  handle : IO.Ref (Option IO.FS.Handle)
+  blockSize : Nat
+  state : IO.Ref SegmentWriterState
+
+namespace SegmentWriter
+
+@[extern "chronos_segment_truncate"]
+private opaque truncateFFI (path : @& String) (size : UInt64) : IO Unit
+
+/-- Open `path` for appending, creating it with `blockSize`-byte blocks if
+    it does not exist. An existing file keeps its own block size, and
+    appends must not go back before its last record. Anything past the
+    last readable block (a block torn by a crash) is truncated away. -/
+def openFile (path : System.FilePath) (blockSize : Nat := Segment.defaultBlockSize) : IO SegmentWriter := do
+  let exists_ ← path.pathExists
+  let existing := exists_ && (← path.metadata).byteSize > 0
+  let (blockSize, lastNs) ←
+    if existing then do
+      let r ← SegmentReader.openFile path
+      let blockSize ← r.blockSize
+      let lastNs := (← r.bounds).map (·.2.toNanoseconds)
+      let validSize := Segment.headerSize + (← r.blockCount) * blockSize
+      if (← path.metadata).byteSize.toNat != validSize then
+        truncateFFI path.toString validSize.toUInt64
+      pure (blockSize, lastNs)
+    else pure (blockSize, none)
+  if blockSize < Segment.blockHeaderSize + Segment.recordSize || blockSize ≥ 2 ^ 32 then
+    throw (IO.userError s!"segment: invalid block size {blockSize}")
+  let handle ← IO.FS.Handle.mk path .append
+  if !existing then handle.write (Segment.encodeHeader blockSize)
+  return { handle := ← IO.mkRef (some handle), blockSize, state := ← IO.mkRef { lastNs } }
+
+private def openHandle (w : SegmentWriter) : IO IO.FS.Handle := do
+  match ← w.handle.get with
+  | some h => return h
+  | none => throw (IO.userError "segment: writer is closed")
+
+/-- Write the pending block, if any. The next record starts a new block,
+    so flushing often leaves blocks partly empty. -/
+def flush (w : SegmentWriter) : IO Unit := do
+  let s ← w.state.get
+  if s.pending.isEmpty then return
+  let h ← w.openHandle
+  h.write (Segment.encodeBlock w.blockSize s.pending)
+  h.flush
+  w.state.set { s with pending := #[], used := Segment.blockHeaderSize }
+
+/-- Append one record. Fails if `ts` is earlier than the previous record,
+    does not fit the int64 nanosecond range (about 1677 to 2262), or the
+    payload cannot fit in a block. -/
+def append (w : SegmentWriter) (ts : Timestamp) (payload : ByteArray) : IO Unit := do
+  let ns := ts.toNanoseconds
+  if ns < Segment.minNs || ns > Segment.maxNs then
+    throw (IO.userError "segment: timestamp outside the int64 nanosecond range")
+  discard w.openHandle
+  let s ← w.state.get
+  if let some last := s.lastNs then
+    if ns < last then throw (IO.userError "segment: timestamps must not decrease")
+  let need := Segment.recordSize + payload.size
+  if Segment.blockHeaderSize + need > w.blockSize then
+    throw (IO.userError s!"segment: payload of {payload.size} bytes exceeds the block size")
+  if s.used + need > w.blockSize then w.flush
+  w.state.modify fun s =>
+    { pending := s.pending.push (ns, payload), used := s.used + need, lastNs := some ns }
+
+/-- Flush and close the file. Later appends fail; closing twice is a no-op. -/
+def close (w : SegmentWriter) : IO Unit := do
+  if (← w.handle.get).isNone then return
+  w.flush
+  w.handle.set none
+
+end SegmentWriter
+
+end Chronos
@@ -0,0 +1,149 @@
+/-
+  Chronos.TimestampIndex
+  Range queries over sorted timestamp arrays.
+
+  Searches start with interpolation probes, which land within a few
+  slots of the answer on near-uniform event streams, and switch to
+  binary search after O(log n) probes so skewed data keeps the
+  logarithmic worst case.
+-/
+
+import Chronos.Interval
+
+namespace Chronos
+
+/-- An index over timestamps sorted ascending (duplicates allowed). -/
+structure TimestampIndex where
+  keys : Array Timestamp
+  deriving Repr, Inhabited
+
+namespace TimestampIndex
+
+/-- Empty index. -/
+def empty : TimestampIndex := { keys := #[] }
+
+/-- Wrap an array that is already sorted ascending. -/
+def ofSorted (keys : Array Timestamp) : TimestampIndex := { keys }
+
+/-- Sort an array and index it. -/
+def ofArray (tss : Array Timestamp) : TimestampIndex :=
+  { keys := tss.qsort (· < ·) }
+
+/-- Number of indexed timestamps. -/
+def size (idx : TimestampIndex) : Nat := idx.keys.size
+
+/-- Whether the index is empty. -/
+def isEmpty (idx : TimestampIndex) : Bool := idx.keys.isEmpty
+
+-- ============================================================================
+-- Search
+-- ============================================================================
+
+/-- Signed seconds from `a` to `b` as a Float. -/
+private def offset (a b : Timestamp) : Float :=
+  Float.ofInt (b.seconds - a.seconds) + (b.nanoseconds.toFloat - a.nanoseconds.toFloat) / 1e9
+
+/-- First index whose key is not `before t`, where `before` is monotone
+    (true on a prefix of the keys). Interpolation probes first, then
+    binary search. -/
+private def search (ks : Array Timestamp) (t : Timestamp) (before : Timestamp → Bool) : Nat := Id.run do
+  -- Invariant: keys below `lo` are before `t`, keys at or above `hi` are not
+  let mut lo := 0
+  let mut hi := ks.size
+  let mut probes := ks.size.log2 + 1
+  while hi - lo > 8 && probes > 0 do
+    probes := probes - 1
+    let a := ks[lo]!
+    let b := ks[hi - 1]!
+    if !before a then return lo
+    if before b then return hi
+    let span := offset a b
+    let frac := if span > 0 then offset a t / span else 0
+    let p := lo + min (hi - 1 - lo) (frac * (hi - 1 - lo).toFloat).toUInt64.toNat
+    if before ks[p]! then lo := p + 1 else hi := p
+  while lo < hi do
+    let mid := (lo + hi) / 2
+    if before ks[mid]! then lo := mid + 1 else hi := mid
+  return lo
+
+/-- Index of the first key `≥ t`. -/
+def lowerBound (idx : TimestampIndex) (t : Timestamp) : Nat :=
+  search idx.keys t (· < t)
+
+/-- Index of the first key `> t`. -/
+def upperBound (idx : TimestampIndex) (t : Timestamp) : Nat :=
+  search idx.keys t (· ≤ t)
+
+/-- Whether `t` is in the index. -/
+def contains (idx : TimestampIndex) (t : Timestamp) : Bool :=
+  idx.keys[idx.lowerBound t]? == some t
+
+/-- Number of keys in `[t1, t2)`. -/
+def countInRange (idx : TimestampIndex) (t1 t2 : Timestamp) : Nat :=
+  if t2 ≤ t1 then 0 else idx.lowerBound t2 - idx.lowerBound t1
+
+/-- Keys in `[t1, t2)`, in order. -/
+def range (idx : TimestampIndex) (t1 t2 : Timestamp) : Array Timestamp :=
+  if t2 ≤ t1 then #[] else idx.keys.extract (idx.lowerBound t1) (idx.lowerBound t2)
+
+/-- Number of keys inside an interval. -/
+def countIn (idx : TimestampIndex) (i : Interval) : Nat :=
+  idx.countInRange i.start i.stop
+
+/-- Keys inside an interval, in order. -/
+def within (idx : TimestampIndex) (i : Interval) : Array Timestamp :=
+  idx.range i.start i.stop
+
+/-- The `k` keys closest to `t`, nearest first (ties prefer the earlier key). -/
+def kNearest (idx : TimestampIndex) (t : Timestamp) (k : Nat) : Array Timestamp := Id.run do
+  let ks := idx.keys
+  let mut out : Array Timestamp := Array.mkEmpty (min k ks.size)
+  -- Two cursors walking outwards: `l` is one past the next earlier key
+  let mut l := idx.lowerBound t
+  let mut r := l
+  while out.size < k && (l > 0 || r < ks.size) do
+    let takeLeft :=
+      if l == 0 then false
+      else if r ≥ ks.size then true
+      else t.diff ks[l - 1]! ≤ ks[r]!.diff t
+    if takeLeft then
+      out := out.push ks[l - 1]!
+      l := l - 1
+    else
+      out := out.push ks[r]!
+      r := r + 1
+  return out
+
+/-- The key closest to `t`, if any. -/
+def nearest? (idx : TimestampIndex) (t : Timestamp) : Option Timestamp :=
+  (idx.kNearest t 1)[0]?
+
+-- ============================================================================
+-- Updates
+-- ============================================================================
+
+/-- Insert a timestamp. Appending in order is O(1); out-of-order
+    inserts shift the tail. -/
+def push (idx : TimestampIndex) (t : Timestamp) : TimestampIndex :=
+  match idx.keys.back? with
+  | none => { keys := #[t] }
+  | some last =>
+    if last ≤ t then { keys := idx.keys.push t }
+    else
+      let i := idx.upperBound t
+      { keys := (idx.keys.extract 0 i).push t ++ idx.keys.extract i idx.keys.size }
+
+/-- Insert many timestamps; an already sorted batch that starts after the
+    last key is appended directly. -/
+def pushAll (idx : TimestampIndex) (tss : Array Timestamp) : TimestampIndex :=
+  let batch := tss.qsort (· < ·)
+  match idx.keys.back?, batch[0]? with
+  | some last, some first =>
+    if last ≤ first then { keys := idx.keys ++ batch }
+    else ofArray (idx.keys ++ batch)
+  | none, _ => { keys := batch }
+  | _, none => idx
+
+end TimestampIndex
+
+end Chronos
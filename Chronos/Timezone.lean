@@ -4,6 +4,7 @@
 -/
 
 import Chronos.Timestamp
+import Std.Data.HashSet
 
 namespace Chronos
 
@@ -14,6 +15,55 @@ opaque TimezonePointed : NonemptyType
 def Timezone := TimezonePointed.type
 instance : Nonempty Timezone := TimezonePointed.property
 
+/-- Where a timezone's rules are read from. -/
+inductive TimezoneSource where
+  /-- Resolved by libc through the TZ environment variable. -/
+  | libc
+  /-- The tzdata snapshot linked into the library (`lake build -K embedTzdata`). -/
+  | embedded
+  /-- A memory-mapped file from the system zoneinfo directory. -/
+  | zoneinfo
+  /-- A POSIX TZ rule string (`Timezone.fromPosix`). -/
+  | posix
+  /-- A constant UTC offset (`Timezone.fixed`). -/
+  | fixed
+  deriving Repr, BEq, Inhabited
+
+namespace TimezoneSource
+
+/-- Decode the FFI source tag. -/
+def ofUInt8 : UInt8 → TimezoneSource
+  | 1 => .embedded
+  | 2 => .zoneinfo
+  | 3 => .posix
+  | 4 => .fixed
+  | _ => .libc
+
+end TimezoneSource
+
+/-- A span of time over which a zone's UTC offset is constant. Within the
+    span, local time is plain addition: `local = utc + offset`. -/
+structure OffsetSpan where
+  /-- Seconds east of UTC. -/
+  offset : Int32
+  /-- First instant of the span; `none` if no earlier change is known. -/
+  start : Option Timestamp
+  /-- Instant the offset next changes; `none` if no later change is known. -/
+  stop : Option Timestamp
+  deriving Repr, BEq, Inhabited
+
+namespace OffsetSpan
+
+/-- Whether `ts` lies in the span. -/
+def contains (s : OffsetSpan) (ts : Timestamp) : Bool :=
+  (s.start.all (· ≤ ts)) && (s.stop.all (ts < ·))
+
+/-- Local wall-clock seconds for a UTC instant inside the span. -/
+def toLocalSeconds (s : OffsetSpan) (ts : Timestamp) : Int :=
+  ts.seconds + s.offset.toInt
+
+end OffsetSpan
+
 namespace Timezone
 
 -- ============================================================================
@@ -24,6 +74,14 @@ namespace Timezone
 @[extern "chronos_timezone_from_name"]
 private opaque fromNameFFI (name : @& String) : IO (Option Timezone)
 
+/-- Raw FFI: Timezone from a POSIX TZ string. Returns none if it does not parse. -/
+@[extern "chronos_timezone_from_posix"]
+private opaque fromPosixFFI (spec : @& String) : IO (Option Timezone)
+
+/-- Raw FFI: Timezone at a constant offset. Returns none if out of range. -/
+@[extern "chronos_timezone_fixed"]
+private opaque fixedFFI (offset : Int32) : IO (Option Timezone)
+
 /-- Raw FFI: Get UTC timezone. -/
 @[extern "chronos_timezone_utc"]
 private opaque utcFFI : IO Timezone
@@ -36,6 +94,43 @@ private opaque localFFI : IO Timezone
 @[extern "chronos_timezone_name"]
 private opaque nameFFI (tz : @& Timezone) : IO String
 
+/-- Raw FFI: Source tag of a loaded timezone. -/
+@[extern "chronos_timezone_source"]
+private opaque sourceFFI (tz : @& Timezone) : IO UInt8
+
+/-- Raw FFI: Prefer the system database over the embedded snapshot. -/
+@[extern "chronos_tzdata_set_prefer_system"]
+private opaque setPreferSystemFFI (prefer : Bool) : IO Unit
+
+/-- Raw FFI: UTC offset in seconds at a UTC instant from zone data.
+    Returns none for zones resolved through libc. -/
+@[extern "chronos_timezone_offset_at"]
+private opaque offsetAtFFI (tz : @& Timezone) (seconds : @& Int) : Option Int
+
+/-- Raw FFI: UTC offset in seconds at a UTC instant through libc. -/
+@[extern "chronos_timezone_libc_offset_at"]
+private opaque libcOffsetAtFFI (tz : @& Timezone) (seconds : @& Int) : IO Int
+
+/-- Raw FFI: Next offset change after (forward) or latest at/before an instant. -/
+@[extern "chronos_timezone_offset_change"]
+private opaque offsetChangeFFI (tz : @& Timezone) (seconds : @& Int) (forward : Bool) : Option Int
+
+/-- Raw FFI: First offset change within a horizon, probing libc if needed. -/
+@[extern "chronos_timezone_probe_change"]
+private opaque probeChangeFFI (tz : @& Timezone) (seconds : @& Int) (horizon : UInt32) : IO (Option Int)
+
+/-- Raw FFI: The zone's POSIX TZ rule string, if it has one. -/
+@[extern "chronos_timezone_posix_rule"]
+private opaque posixRuleFFI (tz : @& Timezone) : Option String
+
+/-- Raw FFI: UTC seconds of DST start and end in a year under the zone's rule. -/
+@[extern "chronos_timezone_rule_transitions"]
+private opaque ruleTransitionsFFI (tz : @& Timezone) (year : @& Int) : Option (Int × Int)
+
+/-- Raw FFI: Zone names in the embedded snapshot. -/
+@[extern "chronos_tzdata_embedded_names"]
+private opaque embeddedNamesFFI : IO (Array String)
+
 -- ============================================================================
 -- Public API
 -- ============================================================================
@@ -52,6 +147,52 @@ private opaque nameFFI (tz : @& Timezone) : IO String
 def fromName (name : String) : IO (Option Timezone) :=
   fromNameFFI name
 
+/-- A timezone defined by a POSIX TZ string, e.g. "EST5EDT,M3.2.0,M11.1.0"
+    or "<+0330>-3:30". Offsets follow POSIX (positive west of Greenwich).
+    A DST name without a rule uses the US rules (",M3.2.0,M11.1.0").
+    Returns `none` if the string does not parse. -/
+def fromPosix (spec : String) : IO (Option Timezone) :=
+  fromPosixFFI spec
+
+/-- A timezone at a constant offset in seconds east of UTC, named like
+    "+05:30". It converts with plain arithmetic and never consults libc.
+    Returns `none` unless the offset is under 24 hours in magnitude. -/
+def fixed (offsetSeconds : Int32) : IO (Option Timezone) :=
+  fixedFFI offsetSeconds
+
+/-- Parse a UTC offset as written in RFC 3339 and ISO 8601 timestamps:
+    "Z", "±HH:MM", "±HHMM" or "±HH". Returns seconds east of UTC. -/
+def parseOffset (s : String) : Option Int32 :=
+  let two (a b : Char) : Option Nat :=
+    if a.isDigit && b.isDigit then some ((a.toNat - '0'.toNat) * 10 + (b.toNat - '0'.toNat)) else none
+  match s.trim.toList with
+  | ['Z'] | ['z'] => some 0
+  | sign :: rest =>
+    if sign != '+' && sign != '-' then none
+    else
+      let hm : Option (Nat × Nat) := match rest with
+        | [h1, h2] => (two h1 h2).map (·, 0)
+        | [h1, h2, ':', m1, m2] | [h1, h2, m1, m2] => do
+          let h ← two h1 h2
+          let m ← two m1 m2
+          pure (h, m)
+        | _ => none
+      match hm with
+      | some (h, m) =>
+        if h > 23 || m > 59 then none
+        else
+          let secs : Int := (h * 3600 + m * 60 : Nat)
+          some (if sign == '-' then -secs else secs).toInt32
+      | none => none
+  | [] => none
+
+/-- A fixed-offset timezone from an offset string such as "+05:30" or "Z"
+    (see `parseOffset`). -/
+def fromOffsetString (s : String) : IO (Option Timezone) :=
+  match parseOffset s with
+  | some offset => fixed offset
+  | none => pure none
+
 /-- The UTC timezone. -/
 def utc : IO Timezone := utcFFI
 
@@ -63,6 +204,176 @@ def localTz : IO Timezone := localFFI
     For the local timezone, returns the system's timezone abbreviation. -/
 def name (tz : Timezone) : IO String := nameFFI tz
 
+/-- Where this timezone's rules are read from. Zones served from in-process
+    data convert without touching the TZ environment variable. -/
+def source (tz : Timezone) : IO TimezoneSource :=
+  return TimezoneSource.ofUInt8 (← sourceFFI tz)
+
+/-- Names of the zones in the embedded tzdata snapshot, sorted.
+    Empty unless the library was built with `-K embedTzdata`. -/
+def embeddedNames : IO (Array String) := embeddedNamesFFI
+
+/-- Prefer the system zoneinfo database for zones it contains, using the
+    embedded snapshot only as a fallback. The same switch is available as
+    `CHRONOS_TZDATA=system` in the environment. Affects later loads only. -/
+def preferSystemDatabase (prefer : Bool := true) : IO Unit :=
+  setPreferSystemFFI prefer
+
+-- ============================================================================
+-- Offsets and transitions
+-- ============================================================================
+
+/-- UTC offset in seconds (local − UTC) at an instant, from in-process
+    zone data: a binary search over the transitions, without building a
+    DateTime. `none` for zones resolved through libc; use `offsetAt`. -/
+def offsetAt? (tz : Timezone) (ts : Timestamp) : Option Int32 :=
+  (offsetAtFFI tz ts.seconds).map Int.toInt32
+
+/-- UTC offset in seconds (local − UTC) at an instant, for any zone.
+    Zones resolved through libc switch `TZ` for the lookup. -/
+def offsetAt (tz : Timezone) (ts : Timestamp) : IO Int32 := do
+  match tz.offsetAt? ts with
+  | some offset => return offset
+  | none => return (← libcOffsetAtFFI tz ts.seconds).toInt32
+
+/-- The first instant after `ts` at which the zone's UTC offset changes.
+    Transitions that only rename the zone (same offset) are skipped.
+    `none` if no change is known (including zones resolved through libc). -/
+def nextTransition (tz : Timezone) (ts : Timestamp) : Option Timestamp :=
+  (offsetChangeFFI tz ts.seconds true).map Timestamp.fromSeconds
+
+/-- The first offset change in the `horizon` seconds after `ts`. Unlike
+    `nextTransition` this also works for zones resolved through libc, which
+    are probed hour by hour (with `TZ` switched once) and bisected to the
+    second; a change and its reversal within one hour are not seen. -/
+def probeNextTransition (tz : Timezone) (ts : Timestamp) (horizon : UInt32 := 604800) :
+    IO (Option Timestamp) :=
+  return (← probeChangeFFI tz ts.seconds horizon).map Timestamp.fromSeconds
+
+/-- The latest instant at or before `ts` at which the offset changed, i.e.
+    the start of the offset period containing `ts`. -/
+def prevTransition (tz : Timezone) (ts : Timestamp) : Option Timestamp :=
+  (offsetChangeFFI tz ts.seconds false).map Timestamp.fromSeconds
+
+/-- The span around `ts` over which the offset stays constant, from zone
+    data. Callers can cache it and convert any instant it contains by plain
+    addition. `none` for zones resolved through libc. -/
+def offsetSpan? (tz : Timezone) (ts : Timestamp) : Option OffsetSpan :=
+  (tz.offsetAt? ts).map fun offset =>
+    ({ offset, start := tz.prevTransition ts, stop := tz.nextTransition ts } : OffsetSpan)
+
+/-- The span around `ts` over which the offset stays constant. Zones
+    resolved through libc report their offset with no known bounds. -/
+def offsetSpan (tz : Timezone) (ts : Timestamp) : IO OffsetSpan := do
+  match tz.offsetSpan? ts with
+  | some span => return span
+  | none => return { offset := ← tz.offsetAt ts, start := none, stop := none }
+
+-- ============================================================================
+-- POSIX rules
+-- ============================================================================
+
+/-- The POSIX TZ string that governs the zone after its last listed
+    transition (the zone file footer), or the whole zone for one built by
+    `fromPosix`. `none` for zones resolved through libc and for zone files
+    without a footer. -/
+def posixRule (tz : Timezone) : Option String := posixRuleFFI tz
+
+/-- The DST start and end instants in `year` under the zone's POSIX rule.
+    Computed arithmetically, so any year works; for years the zone file
+    lists explicitly, the listed transitions take precedence in conversions.
+    In southern-hemisphere rules the end comes before the start. `none` if
+    the zone has no rule or the rule has no DST. -/
+def ruleTransitions (tz : Timezone) (year : Int) : Option (Timestamp × Timestamp) :=
+  (ruleTransitionsFFI tz year).map fun (s, e) => (Timestamp.fromSeconds s, Timestamp.fromSeconds e)
+
+-- ============================================================================
+-- Zone name index
+-- ============================================================================
+
+/-- Known zone names, sorted, with a hash set for membership tests. -/
+structure ZoneIndex where
+  names : Array String
+  set : Std.HashSet String
+
+/-- The system zoneinfo directory (`TZDIR`, default /usr/share/zoneinfo). -/
+def zoneinfoDir : IO System.FilePath := do
+  return (← IO.getEnv "TZDIR").getD "/usr/share/zoneinfo"
+
+/-- Zone and link names declared in a `tzdata.zi` file. -/
+private def namesFromTzdataZi (content : String) : Array String := Id.run do
+  let mut out : Array String := #[]
+  for line in content.splitOn "\n" do
+    match line.splitOn " " with
+    | "Z" :: name :: _ => out := out.push name
+    | "L" :: _ :: name :: _ => out := out.push name
+    | _ => pure ()
+  return out
+
+/-- Zone names listed in a `zone1970.tab` file (third column). -/
+private def namesFromZoneTab (content : String) : Array String := Id.run do
+  let mut out : Array String := #[]
+  for line in content.splitOn "\n" do
+    if line.startsWith "#" then continue
+    match line.splitOn "\t" with
+    | _ :: _ :: name :: _ => out := out.push name
+    | _ => pure ()
+  return out
+
+/-- Zone names found by scanning the directory for TZif files. -/
+private def namesFromDirectory (dir : System.FilePath) : IO (Array String) := do
+  let prefixLen := dir.toString.length + 1
+  let mut out : Array String := #[]
+  for path in ← dir.walkDir do
+    if ← path.isDir then continue
+    let rel := String.ofList (path.toString.toList.drop prefixLen)
+    if rel.startsWith "posix/" || rel.startsWith "right/" then continue
+    let magic ← IO.FS.withFile path .read (·.read 4)
+    if magic.data == #[84, 90, 105, 102] then  -- "TZif"
+      out := out.push rel
+  return out
+
+/-- Zone names from the first available system source: `tzdata.zi`, then
+    `zone1970.tab`, then a directory scan. -/
+private def systemNames (dir : System.FilePath) : IO (Array String) := do
+  if ← (dir / "tzdata.zi").pathExists then
+    return namesFromTzdataZi (← IO.FS.readFile (dir / "tzdata.zi"))
+  if ← (dir / "zone1970.tab").pathExists then
+    return namesFromZoneTab (← IO.FS.readFile (dir / "zone1970.tab"))
+  if ← dir.isDir then
+    return ← namesFromDirectory dir
+  return #[]
+
+/-- Build the index from the system names plus any embedded zones. -/
+private def buildIndex : IO ZoneIndex := do
+  let all := (← systemNames (← zoneinfoDir)) ++ (← embeddedNames) ++ #["UTC"]
+  let set := all.foldl (·.insert ·) ({} : Std.HashSet String)
+  return { names := set.toArray.qsort (· < ·), set }
+
+initialize zoneIndexRef : IO.Ref (Option ZoneIndex) ← IO.mkRef none
+
+/-- The zone name index, built on first use. -/
+def zoneIndex : IO ZoneIndex := do
+  match ← zoneIndexRef.get with
+  | some idx => return idx
+  | none =>
+    let idx ← buildIndex
+    zoneIndexRef.set (some idx)
+    return idx
+
+/-- Rebuild the zone name index (e.g. after a tzdata update). -/
+def refreshZoneIndex : IO Unit := do
+  zoneIndexRef.set (some (← buildIndex))
+
+/-- All known zone names, sorted. -/
+def available : IO (Array String) :=
+  return (← zoneIndex).names
+
+/-- Whether `name` is a known zone name. A hash lookup after the index is
+    built; use this to validate user-supplied zones before `fromName`. -/
+def isAvailable (name : String) : IO Bool :=
+  return (← zoneIndex).set.contains name
+
 end Timezone
 
 end Chronos
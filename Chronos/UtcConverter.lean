@@ -0,0 +1,70 @@
+/-
+  Chronos.UtcConverter
+  Incremental Timestamp → UTC DateTime conversion for near-monotonic streams.
+
+  The converter remembers the date of the last day it decoded. Timestamps
+  that fall on that day only need their time of day split out; any other
+  day takes one epoch-day decode and becomes the new cached day.
+-/
+
+import Chronos.DateTime
+
+namespace Chronos
+
+/-- Cached UTC day for incremental conversion. -/
+structure UtcConverter where
+  /-- Unix seconds of the cached day's midnight. -/
+  dayStart : Int := 0
+  /-- Whether `dayStart` and the date fields are valid. -/
+  valid : Bool := false
+  year : Int32 := 1970
+  month : UInt8 := 1
+  day : UInt8 := 1
+  deriving Repr, Inhabited
+
+namespace UtcConverter
+
+/-- A converter with an empty cache. -/
+def empty : UtcConverter := {}
+
+/-- Whether `ts` falls on the cached day. -/
+@[inline] def hits (c : UtcConverter) (ts : Timestamp) : Bool :=
+  c.valid && c.dayStart ≤ ts.seconds && ts.seconds < c.dayStart + 86400
+
+/-- Convert a timestamp to a UTC DateTime, returning the updated converter. -/
+def convert (c : UtcConverter) (ts : Timestamp) : DateTime × UtcConverter :=
+  let c :=
+    if c.hits ts then c
+    else
+      let days := ts.seconds.fdiv 86400
+      let (y, m, d) := DateTime.civilFromDays days
+      { dayStart := days * 86400, valid := true,
+        year := Int.toInt32 y, month := UInt8.ofNat m, day := UInt8.ofNat d }
+  let sod := (ts.seconds - c.dayStart).toNat
+  ({ year := c.year, month := c.month, day := c.day,
+     hour := UInt8.ofNat (sod / 3600), minute := UInt8.ofNat (sod % 3600 / 60),
+     second := UInt8.ofNat (sod % 60), nanosecond := ts.nanoseconds }, c)
+
+/-- Convert an array of timestamps, reusing the cached day between
+    consecutive elements. Fastest on sorted or clustered input. -/
+def convertAll (tss : Array Timestamp) (c : UtcConverter := {}) : Array DateTime := Id.run do
+  let mut out : Array DateTime := Array.mkEmpty tss.size
+  let mut c := c
+  for ts in tss do
+    let (dt, c') := c.convert ts
+    out := out.push dt
+    c := c'
+  return out
+
+end UtcConverter
+
+namespace DateTime
+
+/-- Convert many timestamps to UTC DateTimes, decoding each distinct
+    consecutive day once. -/
+def fromTimestampsUtc (tss : Array Timestamp) : Array DateTime :=
+  UtcConverter.convertAll tss
+
+end DateTime
+
+end Chronos
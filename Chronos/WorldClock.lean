@@ -0,0 +1,55 @@
+/-
+  Chronos.WorldClock
+  One instant in many timezones, in a single FFI call.
+
+  Offsets for every zone are fetched in one crossing (zones backed by
+  zone data need no TZ switch; each libc-backed zone is switched in once
+  for the whole batch), and the local DateTimes are then built with pure
+  arithmetic.
+-/
+
+import Chronos.DateTime
+import Chronos.Timezone
+
+namespace Chronos
+
+namespace Timezone
+
+/-- Raw FFI: offsets of every zone at every instant, zone-major. -/
+@[extern "chronos_timezones_offsets_at"]
+private opaque offsetsAtFFI (zones : @& Array Timezone) (seconds : @& Array Int) : IO (Array Int)
+
+/-- Raw FFI: UTC seconds at which each zone's wall clock reads `local`. -/
+@[extern "chronos_timezones_from_local"]
+private opaque fromLocalFFI (zones : @& Array Timezone) (local : @& Int) : IO (Array Int)
+
+/-- Local DateTime of `ts` at a given UTC offset. -/
+private def atOffset (ts : Timestamp) (offset : Int) : DateTime :=
+  DateTime.fromTimestampUtcPure { ts with seconds := ts.seconds + offset }
+
+/-- The local DateTime and UTC offset of `ts` in each zone, in zone order. -/
+def convertMany (zones : Array Timezone) (ts : Timestamp) : IO (Array (DateTime × Int32)) := do
+  let offsets ← offsetsAtFFI zones #[ts.seconds]
+  return offsets.map fun off => (atOffset ts off, off.toInt32)
+
+/-- Convert a small batch of instants into every zone. Row `i` holds
+    instant `i` in each zone, in zone order. -/
+def convertBatch (zones : Array Timezone) (tss : Array Timestamp) :
+    IO (Array (Array (DateTime × Int32))) := do
+  let offsets ← offsetsAtFFI zones (tss.map (·.seconds))
+  let n := tss.size
+  return tss.mapIdx fun i ts =>
+    (Array.range zones.size).map fun z =>
+      let off := offsets[z * n + i]!
+      (atOffset ts off, off.toInt32)
+
+/-- The instant at which each zone's wall clock reads `dt`, in zone order.
+    Repeated wall times resolve to the earlier instant; skipped ones are
+    shifted forward by the gap, as in `DateTime.toTimestampInTimezone`. -/
+def resolveMany (zones : Array Timezone) (dt : DateTime) : IO (Array Timestamp) := do
+  let secs ← fromLocalFFI zones dt.toTimestampPure.seconds
+  return secs.map fun s => { seconds := s, nanoseconds := dt.nanosecond }
+
+end Timezone
+
+end Chronos
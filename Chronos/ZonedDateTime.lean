@@ -0,0 +1,132 @@
+/-
+  Chronos.ZonedDateTime
+  An instant in a timezone, with local fields computed on demand.
+
+  The zone's UTC offset is looked up once, at construction. Time-of-day
+  fields are then a division away, and the calendar date is decoded on
+  first use and memoized. Equality, ordering and hashing use the instant
+  alone, so sorting or deduplicating zoned values never decodes a date.
+-/
+
+import Chronos.DateTime
+import Chronos.Timezone
+
+namespace Chronos
+
+/-- A timestamp read in a timezone. -/
+structure ZonedDateTime where
+  /-- The instant. -/
+  instant : Timestamp
+  /-- The zone whose wall clock the fields are read from. -/
+  zone : Timezone
+  /-- UTC offset of `zone` at `instant`, in seconds east of UTC. -/
+  offset : Int32
+  /-- Local date and time, decoded on first use. -/
+  fields : Thunk DateTime
+
+namespace ZonedDateTime
+
+/-- Pair an instant with a zone whose offset at that instant is already
+    known (e.g. from a cached `OffsetSpan`), skipping the lookup. -/
+def withOffset (ts : Timestamp) (tz : Timezone) (offset : Int32) : ZonedDateTime :=
+  { instant := ts, zone := tz, offset,
+    fields := Thunk.mk fun _ =>
+      DateTime.fromTimestampUtcPure { ts with seconds := ts.seconds + offset.toInt } }
+
+/-- Read an instant in a zone. Only the offset is computed here. -/
+def ofTimestamp (ts : Timestamp) (tz : Timezone) : IO ZonedDateTime :=
+  return withOffset ts tz (← tz.offsetAt ts)
+
+/-- The current instant in a zone. -/
+def now (tz : Timezone) : IO ZonedDateTime := do
+  ofTimestamp (← Timestamp.now) tz
+
+/-- The same instant read in another zone. -/
+def withZone (z : ZonedDateTime) (tz : Timezone) : IO ZonedDateTime :=
+  ofTimestamp z.instant tz
+
+/-- Local wall-clock seconds since 1970-01-01. -/
+@[inline] def localSeconds (z : ZonedDateTime) : Int :=
+  z.instant.seconds + z.offset.toInt
+
+/-- Local days since 1970-01-01. -/
+def epochDays (z : ZonedDateTime) : Int :=
+  z.localSeconds.fdiv 86400
+
+/-- Seconds since local midnight. -/
+def secondOfDay (z : ZonedDateTime) : Nat :=
+  (z.localSeconds.fmod 86400).toNat
+
+-- ============================================================================
+-- Fields
+-- ============================================================================
+
+/-- All local fields. Decoded once, then memoized. -/
+def toDateTime (z : ZonedDateTime) : DateTime := z.fields.get
+
+def year (z : ZonedDateTime) : Int32 := z.toDateTime.year
+def month (z : ZonedDateTime) : UInt8 := z.toDateTime.month
+def day (z : ZonedDateTime) : UInt8 := z.toDateTime.day
+
+/-- Local hour, without decoding the date. -/
+def hour (z : ZonedDateTime) : UInt8 := UInt8.ofNat (z.secondOfDay / 3600)
+
+/-- Local minute, without decoding the date. -/
+def minute (z : ZonedDateTime) : UInt8 := UInt8.ofNat (z.secondOfDay % 3600 / 60)
+
+/-- Local second, without decoding the date. -/
+def second (z : ZonedDateTime) : UInt8 := UInt8.ofNat (z.secondOfDay % 60)
+
+def nanosecond (z : ZonedDateTime) : UInt32 := z.instant.nanoseconds
+
+/-- Local day of the week, without decoding the date. -/
+def weekday (z : ZonedDateTime) : Weekday :=
+  DateTime.weekdayOfEpochDays z.epochDays
+
+/-- The local date at midnight (time fields zero). -/
+def date (z : ZonedDateTime) : DateTime :=
+  { z.toDateTime with hour := 0, minute := 0, second := 0, nanosecond := 0 }
+
+/-- The offset as "+HH:MM" (or "+HH:MM:SS" for sub-minute offsets). -/
+def offsetString (z : ZonedDateTime) : String :=
+  let a := z.offset.toInt.natAbs
+  let pad (n : Nat) : String := if n < 10 then s!"0{n}" else toString n
+  let sign := if z.offset < 0 then "-" else "+"
+  let base := s!"{sign}{pad (a / 3600)}:{pad (a % 3600 / 60)}"
+  if a % 60 == 0 then base else s!"{base}:{pad (a % 60)}"
+
+/-- Format as ISO 8601 with the UTC offset: YYYY-MM-DDTHH:MM:SS+HH:MM -/
+def toIso8601 (z : ZonedDateTime) : String :=
+  s!"{z.toDateTime.toIso8601}{z.offsetString}"
+
+instance : ToString ZonedDateTime where
+  toString := toIso8601
+
+-- ============================================================================
+-- Comparison (by instant)
+-- ============================================================================
+
+instance : BEq ZonedDateTime where
+  beq a b := a.instant == b.instant
+
+instance : Ord ZonedDateTime where
+  compare a b := compare a.instant b.instant
+
+instance : LT ZonedDateTime where
+  lt a b := a.instant < b.instant
+
+instance : LE ZonedDateTime where
+  le a b := a.instant ≤ b.instant
+
+instance (a b : ZonedDateTime) : Decidable (a < b) :=
+  inferInstanceAs (Decidable (a.instant < b.instant))
+
+instance (a b : ZonedDateTime) : Decidable (a ≤ b) :=
+  inferInstanceAs (Decidable (a.instant ≤ b.instant))
+
+instance : Hashable ZonedDateTime where
+  hash z := hash z.instant
+
+end ZonedDateTime
+
+end Chronos
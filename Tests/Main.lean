@@ -187,6 +187,38 @@ test "getTimezoneOffset returns reasonable value" := do
   shouldSatisfy (offset >= -43200) "offset >= -43200"
   shouldSatisfy (offset <= 50400) "offset <= 50400"
 
+test "cached timezone offset matches libc" := do
+  DateTime.invalidateTimezoneOffsetCache
+  let cold ← DateTime.getTimezoneOffset
+  let warm ← DateTime.getTimezoneOffset
+  cold ≡ warm
+  warm ≡ (← DateTime.getTimezoneOffsetUncached)
+
+test "local zone key follows the localtime symlink" := do
+  let dir ← Timezone.zoneinfoDir
+  let (h, link) ← IO.FS.createTempFile
+  h.flush
+  IO.FS.removeFile link
+  let point (zone : String) : IO Unit := do
+    discard <| IO.Process.output { cmd := "ln", args := #["-sfn", (dir / zone).toString, link.toString] }
+  point "America/New_York"
+  let a ← DateTime.LocalZoneKey.read link
+  point "Europe/Berlin"
+  let b ← DateTime.LocalZoneKey.read link
+  IO.FS.removeFile link
+  shouldSatisfy (a.target.isSome && a != b) "re-pointing the link changes the key"
+
+test "cached timezone offset is re-read when the zone key changes" := do
+  discard DateTime.getTimezoneOffset
+  let some c ← DateTime.localOffsetCacheRef.get | throw (IO.userError "cache not filled")
+  -- A stale offset under another zone's key, due for a recheck
+  DateTime.localOffsetCacheRef.set (some { c with
+    span := { c.span with offset := c.span.offset + 1 },
+    key := { c.key with target := some ("/nonexistent/zone" : System.FilePath) }, recheckAt := 0 })
+  (← DateTime.getTimezoneOffset) ≡ (← DateTime.getTimezoneOffsetUncached)
+  let some c' ← DateTime.localOffsetCacheRef.get | throw (IO.userError "cache not refilled")
+  shouldSatisfy (c'.key == (← DateTime.LocalZoneKey.read)) "refilled under the current key"
+
 
 
 end DateTimeTests
@@ -629,6 +661,17 @@ test "addDuration crosses day" := do
   result.day ≡ 2
   result.hour ≡ 6
 
+test "negative addDuration borrows nanoseconds across a year" := do
+  let dt : DateTime := { mkDateTime 2025 1 1 0 0 0 with nanosecond := 100 }
+  let result := dt.addDurationPure (Duration.fromNanoseconds (-200))
+  result.toIso8601Full ≡ "2024-12-31T23:59:59.999999900"
+
+test "addDurationPure agrees with timestamp arithmetic" := do
+  let dt : DateTime := { mkDateTime 2024 2 28 23 59 30 with nanosecond := 250000000 }
+  for k in [0:200] do
+    let d := Duration.fromNanoseconds ((k : Int) * 987654321987 - 90000000000000)
+    dt.addDurationPure d ≡ DateTime.fromTimestampUtcPure (dt.toTimestampPure + d)
+
 
 
 end ArithmeticTests
@@ -1119,6 +1162,1216 @@ test "nowInTimezoneE succeeds" := do
 
 end EIOTests
 
+-- ============================================================================
+-- Bucket Tests
+-- ============================================================================
+
+namespace BucketTests
+
+testSuite "Chronos.Bucket"
+
+-- 2025-01-15T14:30:45.5Z (a Wednesday)
+private def sample : Timestamp := { seconds := 1736951445, nanoseconds := 500000000 }
+
+test "truncate to fixed units" := do
+  (Bucket.truncate .second sample) ≡ Timestamp.fromSeconds 1736951445
+  (Bucket.truncate .minute sample) ≡ Timestamp.fromSeconds 1736951400
+  (Bucket.truncate .hour sample) ≡ Timestamp.fromSeconds 1736949600
+  (Bucket.truncate .day sample) ≡ Timestamp.fromSeconds 1736899200
+
+test "truncate to calendar units" := do
+  -- Monday 2025-01-13
+  (Bucket.truncate .isoWeek sample) ≡ Timestamp.fromSeconds 1736726400
+  (Bucket.truncate .month sample) ≡ Timestamp.fromSeconds 1735689600
+  (Bucket.truncate .quarter sample) ≡ Timestamp.fromSeconds 1735689600
+  (Bucket.truncate .year sample) ≡ Timestamp.fromSeconds 1735689600
+
+test "truncate handles pre-epoch timestamps" := do
+  let ts := Timestamp.fromSeconds (-1)
+  (Bucket.truncate .day ts) ≡ Timestamp.fromSeconds (-86400)
+  -- Monday 1969-12-29
+  (Bucket.truncate .isoWeek ts) ≡ Timestamp.fromSeconds (-259200)
+
+test "truncateAll matches truncate across month boundaries" := do
+  let tss := #[Timestamp.fromSeconds 1709208000, Timestamp.fromSeconds 1709294400,
+               Timestamp.fromSeconds 1711929600, Timestamp.fromSeconds 1736951445]
+  for unit in [BucketUnit.isoWeek, .month, .quarter, .year] do
+    (Bucket.truncateAll unit tss) ≡ tss.map (Bucket.truncate unit)
+
+test "bin aligns on origin" := do
+  let origin := Timestamp.fromSeconds 300
+  let w := Duration.fromMinutes 15
+  (Bucket.bin w origin sample) ≡ Timestamp.fromSeconds 1736950800
+  (Bucket.bin w origin (Timestamp.fromSeconds 299)) ≡ Timestamp.fromSeconds (-600)
+  -- Sub-second widths use nanosecond arithmetic
+  (Bucket.bin (Duration.fromMilliseconds 250) Timestamp.epoch sample) ≡ sample
+
+test "countRuns rolls up sorted events" := do
+  let tss := #[Timestamp.fromSeconds 0, Timestamp.fromSeconds 10,
+               Timestamp.fromSeconds 3600, Timestamp.fromSeconds 7300]
+  (Bucket.countRuns .hour tss) ≡
+    #[(Timestamp.fromSeconds 0, 2), (Timestamp.fromSeconds 3600, 1), (Timestamp.fromSeconds 7200, 1)]
+
+test "DateTime.truncate zeroes fields" := do
+  let dt : DateTime := { year := 2025, month := 8, day := 20, hour := 9,
+                         minute := 41, second := 7, nanosecond := 12 }
+  (dt.truncate .hour).toIso8601Full ≡ "2025-08-20T09:00:00.000000000"
+  (dt.truncate .quarter).toIso8601 ≡ "2025-07-01T00:00:00"
+  (dt.truncate .isoWeek).toIso8601 ≡ "2025-08-18T00:00:00"
+
+end BucketTests
+
+-- ============================================================================
+-- Business Calendar Tests
+-- ============================================================================
+
+namespace BusinessCalendarTests
+
+testSuite "Chronos.BusinessCalendar"
+
+private def mkDate (y : Int32) (m d : UInt8) : DateTime :=
+  { year := y, month := m, day := d, hour := 0, minute := 0, second := 0, nanosecond := 0 }
+
+private def cal : BusinessCalendar :=
+  BusinessCalendar.build 2024 2026 (holidays := #[mkDate 2025 1 1, mkDate 2025 12 25])
+
+test "isBusinessDay respects weekends and holidays" := do
+  shouldSatisfy (!cal.isBusinessDay (mkDate 2025 1 1)) "holiday"
+  shouldSatisfy (cal.isBusinessDay (mkDate 2025 1 2)) "thursday"
+  shouldSatisfy (!cal.isBusinessDay (mkDate 2025 1 4)) "saturday"
+  shouldSatisfy (!cal.isBusinessDay (mkDate 2025 1 5)) "sunday"
+
+test "addBusinessDays skips holidays and weekends" := do
+  (cal.addBusinessDays (mkDate 2024 12 31) 1).map (·.toDateString) ≡ some "2025-01-02"
+  (cal.addBusinessDays (mkDate 2024 12 31) 3).map (·.toDateString) ≡ some "2025-01-06"
+  (cal.addBusinessDays (mkDate 2025 1 6) (-3)).map (·.toDateString) ≡ some "2024-12-31"
+
+test "addBusinessDays from a non-business day" := do
+  (cal.addBusinessDays (mkDate 2025 1 4) 1).map (·.toDateString) ≡ some "2025-01-06"
+  (cal.addBusinessDays (mkDate 2025 1 4) (-1)).map (·.toDateString) ≡ some "2025-01-03"
+  (cal.addBusinessDays (mkDate 2025 1 4) 0).map (·.toDateString) ≡ some "2025-01-04"
+
+test "addBusinessDays preserves time of day" := do
+  let dt : DateTime := { mkDate 2025 1 3 with hour := 16, minute := 30 }
+  (cal.addBusinessDays dt 1).map (·.toIso8601) ≡ some "2025-01-06T16:30:00"
+
+test "businessDaysBetween counts half-open range" := do
+  cal.businessDaysBetween (mkDate 2025 1 1) (mkDate 2025 1 8) ≡ 4
+  cal.businessDaysBetween (mkDate 2025 1 8) (mkDate 2025 1 1) ≡ -4
+  cal.businessDaysBetween (mkDate 2025 1 1) (mkDate 2025 1 1) ≡ 0
+
+test "falls back outside the precomputed span" := do
+  (cal.addBusinessDays (mkDate 2030 1 4) 1).map (·.toDateString) ≡ some "2030-01-07"
+  cal.businessDaysBetween (mkDate 2026 12 28) (mkDate 2027 1 4) ≡ 5
+  -- Crossing from the span into the fallback region
+  (cal.addBusinessDays (mkDate 2026 12 31) 1).map (·.toDateString) ≡ some "2027-01-01"
+
+test "counts outside the span match a day walk" := do
+  let wide := BusinessCalendar.build 2000 2002
+    (holidays := #[mkDate 1999 12 24, mkDate 1999 12 25, mkDate 2001 7 4, mkDate 2005 1 3])
+  let walkCount (a b : Int) : Int := Id.run do
+    let mut c := 0
+    for k in [0:(b - a).toNat] do
+      if wide.isBusinessEpochDay (a + k) then c := c + 1
+    return c
+  let a := (mkDate 1999 11 3).toEpochDays
+  let b := (mkDate 2005 2 17).toEpochDays
+  for (lo, hi) in [(a, b), (a, a + 40), (b - 40, b), (a + 13, b - 9)] do
+    wide.businessDaysBetweenEpochDays lo hi ≡ walkCount lo hi
+  for n in ([1, 5, 300, 1400, -1, -7, -900] : List Int) do
+    let some d := wide.addBusinessEpochDays a n | throw (IO.userError "no target")
+    shouldSatisfy (wide.isBusinessEpochDay d) s!"target of {n} is a business day"
+    let between := if n > 0 then walkCount (a + 1) (d + 1) else -walkCount d a
+    between ≡ n
+
+test "custom weekend mask" := do
+  let gulf := BusinessCalendar.build 2025 2025 (weekend := .fridaySaturday)
+  (gulf.addBusinessDays (mkDate 2025 1 2) 1).map (·.toDateString) ≡ some "2025-01-05"
+  WeekendMask.ofDays [.friday, .saturday] ≡ WeekendMask.fridaySaturday
+
+test "degenerate weekend masks" := do
+  -- Sunday to Friday off: a holiday on the only business day costs a week
+  let satOnly := BusinessCalendar.build 2025 2025 (weekend := ⟨0x3F⟩)
+    (holidays := #[mkDate 2030 1 5, mkDate 2030 1 12])
+  (satOnly.addBusinessDays (mkDate 2030 1 1) 1).map (·.toDateString) ≡ some "2030-01-19"
+  (satOnly.addBusinessDays (mkDate 2030 1 20) (-2)).map (·.toDateString) ≡ some "2029-12-29"
+  -- Every day off: there is nothing to count
+  let closed := BusinessCalendar.build 2025 2025 (weekend := ⟨0x7F⟩)
+  (closed.addBusinessDays (mkDate 2025 1 1) 1).isNone ≡ true
+  (closed.addBusinessDays (mkDate 2030 1 1) (-1)).isNone ≡ true
+
+test "bulk variants match scalar calls" := do
+  let dts := #[mkDate 2025 1 1, mkDate 2025 1 2, mkDate 2025 1 4]
+  cal.isBusinessDayAll dts ≡ #[false, true, false]
+  (cal.addBusinessDaysAll dts 1).map (·.map (·.toDateString)) ≡
+    #[some "2025-01-02", some "2025-01-03", some "2025-01-06"]
+  cal.businessDaysBetweenAll #[(mkDate 2025 1 1, mkDate 2025 1 8)] ≡ #[4]
+
+end BusinessCalendarTests
+
+-- ============================================================================
+-- Recurrence Tests
+-- ============================================================================
+
+namespace RecurrenceTests
+
+testSuite "Chronos.Recurrence"
+
+private def mkDateTime (y : Int32) (mo d h mi : UInt8) : DateTime :=
+  { year := y, month := mo, day := d, hour := h, minute := mi, second := 0, nanosecond := 0 }
+
+private def dates (xs : Array DateTime) : Array String := xs.map (·.toDateString)
+
+private def parseOrThrow (s : String) : IO RRule :=
+  match RRule.parse s with
+  | .ok r => pure r
+  | .error e => throw (IO.userError s!"parse failed: {e}")
+
+test "parse reads all supported parts" := do
+  let r ← parseOrThrow "RRULE:FREQ=WEEKLY;INTERVAL=2;BYDAY=MO,-1FR;COUNT=4;WKST=MO"
+  r.freq ≡ Frequency.weekly
+  r.interval ≡ 2
+  r.count ≡ some 4
+  r.byDay.map (·.ordinal) ≡ #[none, some (-1)]
+  let u ← parseOrThrow "FREQ=DAILY;UNTIL=20250103T120000Z"
+  u.untilUtc ≡ true
+  (u.«until».map (·.toIso8601)) ≡ some "2025-01-03T12:00:00"
+
+test "parse rejects invalid rules" := do
+  shouldSatisfy (RRule.parse "FREQ=HOURLY" matches .error _) "unsupported FREQ"
+  shouldSatisfy (RRule.parse "INTERVAL=2" matches .error _) "missing FREQ"
+  shouldSatisfy (RRule.parse "FREQ=DAILY;BYDAY=XX" matches .error _) "bad weekday"
+  shouldSatisfy (RRule.parse "FREQ=DAILY;COUNT=2;UNTIL=20250101" matches .error _) "COUNT and UNTIL"
+
+test "daily with COUNT keeps time of day" := do
+  let r ← parseOrThrow "FREQ=DAILY;COUNT=3"
+  let occ := (r.iter (mkDateTime 2025 1 30 9 15)).take 10
+  occ.map (·.toIso8601) ≡ #["2025-01-30T09:15:00", "2025-01-31T09:15:00", "2025-02-01T09:15:00"]
+
+test "weekly BYDAY skips days before DTSTART" := do
+  let r ← parseOrThrow "FREQ=WEEKLY;BYDAY=MO,WE,FR;COUNT=4"
+  dates ((r.iter (mkDateTime 2025 1 15 0 0)).take 10) ≡
+    #["2025-01-15", "2025-01-17", "2025-01-20", "2025-01-22"]
+
+test "monthly BYMONTHDAY skips short months" := do
+  let r ← parseOrThrow "FREQ=MONTHLY;BYMONTHDAY=31;COUNT=3"
+  dates ((r.iter (mkDateTime 2025 1 31 0 0)).take 10) ≡ #["2025-01-31", "2025-03-31", "2025-05-31"]
+
+test "monthly last Friday" := do
+  let r ← parseOrThrow "FREQ=MONTHLY;BYDAY=-1FR"
+  dates ((r.iter (mkDateTime 2025 1 1 0 0)).take 3) ≡ #["2025-01-31", "2025-02-28", "2025-03-28"]
+
+test "yearly leap day recurs every four years" := do
+  let r ← parseOrThrow "FREQ=YEARLY;COUNT=2"
+  dates ((r.iter (mkDateTime 2024 2 29 0 0)).take 5) ≡ #["2024-02-29", "2028-02-29"]
+
+test "UNTIL is inclusive" := do
+  let r ← parseOrThrow "FREQ=DAILY;UNTIL=20250103"
+  dates ((r.iter (mkDateTime 2025 1 1 0 0)).take 10) ≡ #["2025-01-01", "2025-01-02", "2025-01-03"]
+
+test "iterFrom jumps to the containing period" := do
+  let r ← parseOrThrow "FREQ=DAILY;INTERVAL=2"
+  let it := r.iterFrom (mkDateTime 2025 1 1 0 0) (mkDateTime 2025 3 2 12 0)
+  dates (it.take 2) ≡ #["2025-03-04", "2025-03-06"]
+
+test "iterFrom keeps COUNT bookkeeping" := do
+  let r ← parseOrThrow "FREQ=WEEKLY;BYDAY=MO,WE,FR;COUNT=10"
+  let it := r.iterFrom (mkDateTime 2025 1 15 0 0) (mkDateTime 2025 2 3 0 0)
+  dates (it.take 5) ≡ #["2025-02-03", "2025-02-05"]
+
+test "iterator works with for loops" := do
+  let r ← parseOrThrow "FREQ=DAILY;COUNT=5"
+  let mut n := 0
+  for _ in r.iter (mkDateTime 2025 1 1 0 0) do
+    n := n + 1
+  n ≡ 5
+
+end RecurrenceTests
+
+-- ============================================================================
+-- Range Tests
+-- ============================================================================
+
+namespace RangeTests
+
+testSuite "Chronos.Range"
+
+private def mkDateTime (y : Int32) (mo d h mi : UInt8) : DateTime :=
+  { year := y, month := mo, day := d, hour := h, minute := mi, second := 0, nanosecond := 0 }
+
+test "daily range crosses month and year boundaries" := do
+  let r := DateTimeRange.daily (mkDateTime 2024 12 30 6 0) (mkDateTime 2025 1 2 0 0)
+  r.toArray.map (·.toIso8601) ≡
+    #["2024-12-30T06:00:00", "2024-12-31T06:00:00", "2025-01-01T06:00:00"]
+
+test "hourly range carries into the next day" := do
+  let r := DateTimeRange.hourly (mkDateTime 2024 2 28 22 0) (mkDateTime 2024 2 29 1 0)
+  r.toArray.map (·.toIso8601) ≡
+    #["2024-02-28T22:00:00", "2024-02-28T23:00:00", "2024-02-29T00:00:00"]
+
+test "fixed steps longer than a day" := do
+  let r := DateTimeRange.every (mkDateTime 2025 1 1 12 0) (mkDateTime 2025 1 5 0 0)
+    (Duration.fromHours 36)
+  r.toArray.map (·.toIso8601) ≡
+    #["2025-01-01T12:00:00", "2025-01-03T00:00:00", "2025-01-04T12:00:00"]
+
+test "incremental steps agree with addDurationPure" := do
+  let start := mkDateTime 2023 12 31 23 50
+  let step := Duration.fromMinutes 7
+  let r := DateTimeRange.every start (mkDateTime 2024 3 2 0 0) step
+  let mut expected := start
+  let mut n := 0
+  for dt in r do
+    dt ≡ expected
+    expected := expected.addDurationPure step
+    n := n + 1
+  shouldSatisfy (n > 12000) "iterated the whole range"
+
+test "long day steps jump across months" := do
+  let r := DateTimeRange.daily (mkDateTime 2025 1 15 0 0) (mkDateTime 2025 12 31 0 0) 100
+  r.toArray.map (·.toDateString) ≡ #["2025-01-15", "2025-04-25", "2025-08-03", "2025-11-11"]
+
+test "monthly range anchors clamped days" := do
+  let r := DateTimeRange.monthly (mkDateTime 2025 1 31 0 0) (mkDateTime 2025 5 1 0 0)
+  r.toArray.map (·.toDateString) ≡ #["2025-01-31", "2025-02-28", "2025-03-31", "2025-04-30"]
+
+test "non-positive steps are empty" := do
+  let a := mkDateTime 2025 1 1 0 0
+  let b := mkDateTime 2025 1 2 0 0
+  (DateTime.range a b (.fixed Duration.zero)).toArray.size ≡ 0
+  (DateTime.range a b (.days 0)).toArray.size ≡ 0
+  (DateTime.range b a (.days 1)).toArray.size ≡ 0
+
+end RangeTests
+
+-- ============================================================================
+-- LeapSecond Tests
+-- ============================================================================
+
+namespace LeapSecondTests
+
+testSuite "Chronos.LeapSecond"
+
+private def table := LeapSecondTable.builtin
+
+test "utcToTai applies the offset in effect" := do
+  (table.utcToTai (Timestamp.fromSeconds 1483228800)).seconds ≡ 1483228837
+  (table.utcToTai (Timestamp.fromSeconds 1483228799)).seconds ≡ 1483228835
+  (table.utcToTai (Timestamp.fromSeconds 0)).seconds ≡ 10
+
+test "taiToUtc round-trips outside leap seconds" := do
+  for s in [0, 78796799, 78796800, 1435708799, 1483228800, 1704067200] do
+    let ts := Timestamp.fromSeconds s
+    table.taiToUtc (table.utcToTai ts) ≡ ts
+
+test "TAI inside a leap second is flagged" := do
+  let (utc, leap) := table.taiToUtcLeap (Timestamp.fromSeconds 1483228836)
+  utc.seconds ≡ 1483228799
+  leap ≡ true
+  table.formatUtc (Timestamp.fromSeconds 1483228836) ≡ "2016-12-31T23:59:60"
+  table.formatUtc (Timestamp.fromSeconds 1483228837) ≡ "2017-01-01T00:00:00"
+
+test "parseUtc accepts only real leap seconds" := do
+  match table.parseUtc "2016-12-31T23:59:60" with
+  | .ok tai => tai.seconds ≡ 1483228836
+  | .error e => throw (IO.userError s!"parse failed: {e}")
+  match table.parseUtc "2017-12-31T23:59:60" with
+  | .ok _ => throw (IO.userError "should have failed")
+  | .error _ => pure ()
+
+test "GPS conversions and week numbers" := do
+  let gps := table.utcToGps (Timestamp.fromSeconds 1704067200)
+  gps.seconds ≡ 1388102418
+  LeapSecondTable.gpsWeek gps ≡ (2295, 86418)
+  (table.gpsToUtc gps).seconds ≡ 1704067200
+
+test "bulk conversions match single conversions" := do
+  let tss := #[0, 63072000, 1483228799, 1483228800, 1483228801, 1704067200].map Timestamp.fromSeconds
+  table.utcToTaiAll tss ≡ tss.map table.utcToTai
+  let tais := #[1483228834, 1483228835, 1483228836, 1483228837].map Timestamp.fromSeconds
+  table.taiToUtcAll tais ≡ tais.map table.taiToUtc
+
+test "parseList reads entries and expiry" := do
+  let content := "# comment\n#@\t3913697179\n2272060800\t10\t# 1 Jan 1972\n2287785600\t11\t# 1 Jul 1972\n"
+  match LeapSecondTable.parseList content with
+  | .ok t =>
+    t.entries.size ≡ 2
+    t.entries[1]!.effective ≡ 78796800
+    t.expires ≡ some 1704708379
+  | .error e => throw (IO.userError s!"parse failed: {e}")
+
+end LeapSecondTests
+
+-- ============================================================================
+-- Interval Tests
+-- ============================================================================
+
+namespace IntervalTests
+
+testSuite "Chronos.Interval"
+
+private def iv (a b : Int) : Interval :=
+  { start := Timestamp.fromSeconds a, stop := Timestamp.fromSeconds b }
+
+test "overlaps is half-open" := do
+  (iv 0 10).overlaps (iv 5 15) ≡ true
+  (iv 0 10).overlaps (iv 10 20) ≡ false
+  (iv 0 10).overlaps (iv 3 3) ≡ false
+
+test "intersection, union and gap" := do
+  (iv 0 10).intersection? (iv 5 15) ≡ some (iv 5 10)
+  (iv 0 10).intersection? (iv 10 15) ≡ none
+  (iv 0 10).union? (iv 10 15) ≡ some (iv 0 15)
+  (iv 0 10).union? (iv 11 15) ≡ none
+  (iv 0 10).gap? (iv 12 15) ≡ some (iv 10 12)
+  (iv 12 15).gap? (iv 0 10) ≡ some (iv 10 12)
+  (iv 0 10).gap? (iv 5 15) ≡ none
+
+test "mergeAll and gaps" := do
+  let xs := #[iv 20 30, iv 0 5, iv 4 10, iv 10 12, iv 40 41, iv 7 7]
+  Interval.mergeAll xs ≡ #[iv 0 12, iv 20 30, iv 40 41]
+  Interval.gaps xs ≡ #[iv 12 20, iv 30 40]
+
+test "tree overlap and stabbing queries" := do
+  let t := IntervalTree.build #[(iv 0 10, "a"), (iv 5 7, "b"), (iv 20 30, "c"), (iv 8 25, "d")]
+  ((t.overlapping (iv 6 9)).map (·.2)) ≡ #["a", "b", "d"]
+  ((t.overlapping (iv 10 20)).map (·.2)) ≡ #["d"]
+  ((t.stab (Timestamp.fromSeconds 22)).map (·.2)) ≡ #["d", "c"]
+  t.overlapsAny (iv 30 40) ≡ false
+  t.overlapsAny (iv 29 40) ≡ true
+
+test "tree queries match a linear scan" := do
+  let mut xs : Array Interval := #[]
+  let mut seed : Nat := 12345
+  for _ in [0:500] do
+    seed := (seed * 1103515245 + 12345) % 2147483648
+    let a := (seed % 10000 : Nat)
+    seed := (seed * 1103515245 + 12345) % 2147483648
+    xs := xs.push (iv a (a + seed % 300))
+  let t := IntervalTree.ofIntervals xs
+  for k in [0:50] do
+    let q := iv (k * 200) (k * 200 + 150)
+    let expected := xs.filter (·.overlaps q)
+    (t.overlapping q).size ≡ expected.size
+    t.overlapsAny q ≡ !expected.isEmpty
+
+end IntervalTests
+
+-- ============================================================================
+-- TimestampIndex Tests
+-- ============================================================================
+
+namespace TimestampIndexTests
+
+testSuite "Chronos.TimestampIndex"
+
+private def ts (s : Int) : Timestamp := Timestamp.fromSeconds s
+
+private def idx : TimestampIndex := TimestampIndex.ofArray (#[50, 10, 20, 20, 30, 40].map ts)
+
+test "lower and upper bounds" := do
+  idx.lowerBound (ts 20) ≡ 1
+  idx.upperBound (ts 20) ≡ 3
+  idx.lowerBound (ts 5) ≡ 0
+  idx.lowerBound (ts 60) ≡ 6
+  idx.contains (ts 30) ≡ true
+  idx.contains (ts 31) ≡ false
+
+test "range queries are half-open" := do
+  idx.countInRange (ts 20) (ts 40) ≡ 3
+  idx.range (ts 15) (ts 45) ≡ #[ts 20, ts 20, ts 30, ts 40]
+  idx.countIn { start := ts 40, stop := ts 41 } ≡ 1
+  idx.countInRange (ts 40) (ts 20) ≡ 0
+
+test "interpolation search agrees with a linear scan" := do
+  -- Uniform stream with a skewed tail
+  let mut keys : Array Timestamp := #[]
+  for i in [0:5000] do
+    keys := keys.push (ts (1700000000 + i * 7))
+  for i in [0:100] do
+    keys := keys.push (ts (1800000000 + i * i * 1000))
+  let big := TimestampIndex.ofSorted keys
+  for q in [1699999990, 1700000000, 1700012345, 1700034993, 1700035000, 1750000000, 1800004000] do
+    big.lowerBound (ts q) ≡ (keys.filter (· < ts q)).size
+    big.upperBound (ts q) ≡ (keys.filter (· ≤ ts q)).size
+
+test "kNearest walks outwards from the query" := do
+  idx.kNearest (ts 27) 3 ≡ #[ts 30, ts 20, ts 20]
+  idx.kNearest (ts 100) 2 ≡ #[ts 50, ts 40]
+  (idx.kNearest (ts 0) 10).size ≡ 6
+  idx.nearest? (ts 44) ≡ some (ts 40)
+  TimestampIndex.empty.nearest? (ts 0) ≡ none
+
+test "push keeps keys sorted" := do
+  let i := (idx.push (ts 60)).push (ts 25)
+  i.keys ≡ #[10, 20, 20, 25, 30, 40, 50, 60].map ts
+  (i.pushAll #[ts 70, ts 65]).keys.back? ≡ some (ts 70)
+  (i.pushAll #[ts 5]).keys[0]? ≡ some (ts 5)
+
+end TimestampIndexTests
+
+-- ============================================================================
+-- LocalDays Tests
+-- ============================================================================
+
+namespace LocalDaysTests
+
+testSuite "Chronos.LocalDays"
+
+private def withNewYork (f : Timezone → IO Unit) : IO Unit := do
+  match ← Timezone.fromName "America/New_York" with
+  | some tz => f tz
+  | none => throw (IO.userError "Could not load America/New_York")
+
+private def march9 : DateTime :=
+  { year := 2024, month := 3, day := 9, hour := 0, minute := 0, second := 0, nanosecond := 0 }
+
+test "day boundaries across spring-forward" := withNewYork fun tz => do
+  let bs ← tz.dayBoundaries march9 3
+  bs.map (·.seconds) ≡ #[1709960400, 1710046800, 1710129600, 1710216000]
+  let days ← tz.localDays march9 3
+  days.map (·.duration.toSeconds) ≡ #[86400, 82800, 86400]
+
+test "fall-back day has 25 hour boundaries" := withNewYork fun tz => do
+  let nov3 : DateTime := { march9 with month := 11, day := 3 }
+  let hs ← tz.hourBoundaries nov3 1
+  hs.size ≡ 26
+  hs[0]!.seconds ≡ 1730606400
+  hs.back!.seconds ≡ 1730696400
+
+test "spring-forward day skips the missing hour" := withNewYork fun tz => do
+  let hs ← tz.hourBoundaries { march9 with day := 10 } 1
+  hs.size ≡ 24
+  let six ← tz.hourBoundaries { march9 with day := 10 } 1 6
+  six.map (·.seconds) ≡ #[1710046800, 1710064800, 1710086400, 1710108000, 1710129600]
+
+test "groupByLocalDay buckets events by local date" := withNewYork fun tz => do
+  let events := #[1710046800, 1710200000, 1710046799, 1710129599].map Timestamp.fromSeconds
+  let groups ← tz.groupByLocalDay events
+  groups.map (·.1.toDateString) ≡ #["2024-03-09", "2024-03-10", "2024-03-11"]
+  groups.map (·.2.size) ≡ #[1, 2, 1]
+  (← tz.countByLocalDay #[]).size ≡ 0
+
+end LocalDaysTests
+
+-- ============================================================================
+-- UtcConverter Tests
+-- ============================================================================
+
+namespace UtcConverterTests
+
+testSuite "Chronos.UtcConverter"
+
+test "cached conversions match the pure decoder" := do
+  let tss := #[1700000000, 1700000001, 1700050000, 1700086399, 1700086400, 1600000000, -1, 0].map
+    Timestamp.fromSeconds
+  DateTime.fromTimestampsUtc tss ≡ tss.map DateTime.fromTimestampUtcPure
+
+test "converter reuses the cached day" := do
+  let (dt, c) := UtcConverter.empty.convert ⟨1700000000, 5⟩
+  dt.toIso8601Full ≡ "2023-11-14T22:13:20.000000005"
+  c.hits (Timestamp.fromSeconds 1700006399) ≡ true
+  c.hits (Timestamp.fromSeconds 1700006400) ≡ false
+
+test "matches gmtime_r over a sorted stream" := do
+  let tss := (Array.range 500).map fun i => Timestamp.fromSeconds (1709000000 + (i : Int) * 3571)
+  let expected ← tss.mapM DateTime.fromTimestampUtc
+  DateTime.fromTimestampsUtc tss ≡ expected
+
+end UtcConverterTests
+
+-- ============================================================================
+-- Timezone Data Tests
+-- ============================================================================
+
+namespace TimezoneDataTests
+
+testSuite "Chronos.Timezone data"
+
+private def loadZone (name : String) : IO Timezone := do
+  match ← Timezone.fromName name with
+  | some tz => pure tz
+  | none => throw (IO.userError s!"Could not load {name}")
+
+test "embedded zone names are sorted" := do
+  let names ← Timezone.embeddedNames
+  shouldSatisfy (names.toList.zip names.toList.tail |>.all fun (a, b) => a < b) "sorted"
+
+test "conversions agree across database preferences" := do
+  let stamps := #[0, 1710054000, 1730613600, 1730617200, 2000000000].map Timestamp.fromSeconds
+  Timezone.preferSystemDatabase true
+  let sys ← loadZone "America/New_York"
+  Timezone.preferSystemDatabase false
+  let dflt ← loadZone "America/New_York"
+  for ts in stamps do
+    (← DateTime.fromTimestampInTimezone ts sys) ≡ (← DateTime.fromTimestampInTimezone ts dflt)
+
+test "embedded snapshot serves zones when linked" := do
+  let names ← Timezone.embeddedNames
+  -- Only built with -K embedTzdata
+  if names.isEmpty then return
+  Timezone.preferSystemDatabase false
+  let tz ← loadZone "America/New_York"
+  (← tz.source) ≡ .embedded
+  tz.offsetAt? (Timestamp.fromSeconds 1719792000) ≡ some (-14400)
+  tz.offsetAt? (Timestamp.fromSeconds 1704067200) ≡ some (-18000)
+
+test "system zones load from zoneinfo data" := do
+  let tz ← loadZone "Europe/Berlin"
+  let src ← tz.source
+  shouldSatisfy (src == .zoneinfo || src == .embedded) "served from in-process data"
+
+test "zoneinfo zones keep DST past the last transition" := do
+  let tz ← loadZone "America/New_York"
+  let dt ← DateTime.fromTimestampInTimezone (Timestamp.fromSeconds 2224756800) tz
+  dt.hour ≡ 8
+
+test "zone index lists and validates names" := do
+  let names ← Timezone.available
+  shouldSatisfy (names.contains "America/New_York") "lists America/New_York"
+  (← Timezone.isAvailable "Europe/Berlin") ≡ true
+  (← Timezone.isAvailable "UTC") ≡ true
+  (← Timezone.isAvailable "Mars/Olympus_Mons") ≡ false
+
+test "every indexed zone loads" := do
+  for name in (← Timezone.available).extract 0 50 do
+    match ← Timezone.fromName name with
+    | some _ => pure ()
+    | none => throw (IO.userError s!"indexed zone {name} failed to load")
+
+test "offsetAt follows DST" := do
+  let tz ← loadZone "America/New_York"
+  (← tz.offsetAt (Timestamp.fromSeconds 1704067200)) ≡ -18000
+  (← tz.offsetAt (Timestamp.fromSeconds 1719792000)) ≡ -14400
+  (← (← Timezone.utc).offsetAt (Timestamp.fromSeconds 1719792000)) ≡ 0
+  tz.offsetAt? (Timestamp.fromSeconds 1719792000) ≡ some (-14400)
+
+test "next and previous transitions" := do
+  let tz ← loadZone "America/New_York"
+  tz.nextTransition (Timestamp.fromSeconds 1710000000) ≡ some (Timestamp.fromSeconds 1710054000)
+  tz.prevTransition (Timestamp.fromSeconds 1720000000) ≡ some (Timestamp.fromSeconds 1710054000)
+  tz.nextTransition (Timestamp.fromSeconds 1720000000) ≡ some (Timestamp.fromSeconds 1730613600)
+  (← Timezone.utc).nextTransition (Timestamp.fromSeconds 0) ≡ none
+
+test "probing finds the next transition within a horizon" := do
+  let tz ← loadZone "America/New_York"
+  (← tz.probeNextTransition (Timestamp.fromSeconds 1710000000)) ≡ some (Timestamp.fromSeconds 1710054000)
+  (← tz.probeNextTransition (Timestamp.fromSeconds 1710000000) 3600) ≡ none
+
+test "cached offset span converts by addition" := do
+  let tz ← loadZone "Europe/Berlin"
+  let span ← tz.offsetSpan (Timestamp.fromSeconds 1720000000)
+  for k in [0:20] do
+    let ts := Timestamp.fromSeconds (1720000000 + k * 400000)
+    if span.contains ts then
+      let dt ← DateTime.fromTimestampInTimezone ts tz
+      dt.toTimestampPure.seconds ≡ span.toLocalSeconds ts
+  span.contains (Timestamp.fromSeconds 1735689600) ≡ false
+
+test "zone names cannot escape the zoneinfo directory" := do
+  let tz ← Timezone.fromName "../../etc/passwd"
+  match tz with
+  | some z => (← z.source) ≡ .libc
+  | none => pure ()
+
+test "POSIX rule zones compute transitions for any year" := do
+  match ← Timezone.fromPosix "EST5EDT,M3.2.0,M11.1.0" with
+  | none => throw (IO.userError "POSIX rule failed to parse")
+  | some tz =>
+    (← tz.source) ≡ .posix
+    tz.posixRule ≡ some "EST5EDT,M3.2.0,M11.1.0"
+    tz.ruleTransitions 2024 ≡ some (Timestamp.fromSeconds 1710054000, Timestamp.fromSeconds 1730613600)
+    (← tz.offsetAt (Timestamp.fromSeconds 4118083200)) ≡ -14400
+    tz.nextTransition (Timestamp.fromSeconds 1710000000) ≡ some (Timestamp.fromSeconds 1710054000)
+
+test "POSIX rules cover southern DST and reject malformed strings" := do
+  match ← Timezone.fromPosix "AEST-10AEDT,M10.1.0,M4.1.0/3" with
+  | none => throw (IO.userError "POSIX rule failed to parse")
+  | some tz =>
+    tz.ruleTransitions 2024 ≡ some (Timestamp.fromSeconds 1728144000, Timestamp.fromSeconds 1712419200)
+    (← tz.offsetAt (Timestamp.fromSeconds 1704067200)) ≡ 39600
+  shouldSatisfy (← Timezone.fromPosix "EST").isNone "missing offset"
+  shouldSatisfy (← Timezone.fromPosix "EST5EDT,M13.1.0,M11.1.0").isNone "bad month"
+
+test "loaded zones follow their footer rule past the table" := do
+  let tz ← loadZone "America/New_York"
+  tz.posixRule ≡ some "EST5EDT,M3.2.0,M11.1.0"
+  tz.nextTransition (Timestamp.fromSeconds 7259328000) ≡ some (Timestamp.fromSeconds 7263932400)
+  (← tz.offsetAt (Timestamp.fromSeconds 7263932400)) ≡ -14400
+
+test "offset strings parse to seconds east of UTC" := do
+  Timezone.parseOffset "+05:30" ≡ some 19800
+  Timezone.parseOffset "-0330" ≡ some (-12600)
+  Timezone.parseOffset "+01" ≡ some 3600
+  Timezone.parseOffset "Z" ≡ some 0
+  Timezone.parseOffset "+24:00" ≡ none
+  Timezone.parseOffset "05:30" ≡ none
+
+test "fixed-offset zones convert by arithmetic" := do
+  match ← Timezone.fromOffsetString "+05:30" with
+  | none => throw (IO.userError "fixed offset failed")
+  | some tz =>
+    (← tz.name) ≡ "+05:30"
+    (← tz.source) ≡ .fixed
+    (← tz.offsetAt (Timestamp.fromSeconds 1719792000)) ≡ 19800
+    tz.nextTransition (Timestamp.fromSeconds 0) ≡ none
+    let dt ← DateTime.fromTimestampInTimezone (Timestamp.fromSeconds 0) tz
+    dt.hour ≡ 5
+    dt.minute ≡ 30
+    (← dt.toTimestampInTimezone tz).seconds ≡ 0
+  shouldSatisfy (← Timezone.fixed 86400).isNone "offset out of range"
+
+end TimezoneDataTests
+
+-- ============================================================================
+-- World Clock Tests
+-- ============================================================================
+
+namespace WorldClockTests
+
+testSuite "Chronos.WorldClock"
+
+private def loadZones (names : Array String) : IO (Array Timezone) :=
+  names.mapM fun name => do
+    match ← Timezone.fromName name with
+    | some tz => pure tz
+    | none => throw (IO.userError s!"Could not load {name}")
+
+test "one instant in many zones matches per-zone conversion" := do
+  let zones := (← loadZones #["America/New_York", "Europe/London", "Asia/Kolkata"]).push (← Timezone.utc)
+  let ts := Timestamp.fromSeconds 1719792000
+  let results ← Timezone.convertMany zones ts
+  results.size ≡ zones.size
+  for (tz, (dt, off)) in zones.zip results do
+    dt ≡ (← DateTime.fromTimestampInTimezone ts tz)
+    off ≡ (← tz.offsetAt ts)
+  results.map (·.2) ≡ #[-14400, 3600, 19800, 0]
+
+test "batch rows follow instant order" := do
+  let zones ← loadZones #["America/New_York", "Australia/Sydney"]
+  let tss := #[1704067200, 1719792000].map Timestamp.fromSeconds
+  let rows ← Timezone.convertBatch zones tss
+  rows.map (·.map (·.2)) ≡ #[#[-18000, 39600], #[-14400, 36000]]
+
+test "one wall time resolves in many zones" := do
+  let zones ← loadZones #["America/New_York", "Europe/Berlin"]
+  let dt : DateTime := { year := 2024, month := 7, day := 1, hour := 9, minute := 0, second := 0, nanosecond := 0 }
+  let tss ← Timezone.resolveMany zones dt
+  for (tz, ts) in zones.zip tss do
+    ts ≡ (← dt.toTimestampInTimezone tz)
+
+end WorldClockTests
+
+-- ============================================================================
+-- ZonedDateTime Tests
+-- ============================================================================
+
+namespace ZonedDateTimeTests
+
+testSuite "Chronos.ZonedDateTime"
+
+private def newYork : IO Timezone := do
+  match ← Timezone.fromName "America/New_York" with
+  | some tz => pure tz
+  | none => throw (IO.userError "Could not load America/New_York")
+
+test "lazy fields match a full conversion" := do
+  let tz ← newYork
+  for s in [0, 1710054000, 1719792000, 1730613599, 1730613600] do
+    let ts := Timestamp.fromSeconds s
+    let z ← ZonedDateTime.ofTimestamp ts tz
+    let dt ← DateTime.fromTimestampInTimezone ts tz
+    z.toDateTime ≡ dt
+    z.hour ≡ dt.hour
+    z.minute ≡ dt.minute
+    z.weekday ≡ dt.weekdayPure
+
+test "formats with the offset" := do
+  let z ← ZonedDateTime.ofTimestamp (Timestamp.fromSeconds 1719792000) (← newYork)
+  z.toIso8601 ≡ "2024-06-30T20:00:00-04:00"
+
+test "comparison uses the instant alone" := do
+  let tz ← newYork
+  let a ← ZonedDateTime.ofTimestamp (Timestamp.fromSeconds 100) tz
+  let b ← ZonedDateTime.ofTimestamp (Timestamp.fromSeconds 100) (← Timezone.utc)
+  let c ← ZonedDateTime.ofTimestamp (Timestamp.fromSeconds 50) tz
+  (a == b) ≡ true
+  (hash a == hash b) ≡ true
+  (c < a) ≡ true
+  (#[a, c].qsort (· < ·)).map (·.instant.seconds) ≡ #[50, 100]
+
+end ZonedDateTimeTests
+
+-- ============================================================================
+-- DST Policy Tests
+-- ============================================================================
+
+namespace DstPolicyTests
+
+testSuite "Chronos.DstPolicy"
+
+private def newYork : IO Timezone := do
+  match ← Timezone.fromName "America/New_York" with
+  | some tz => pure tz
+  | none => throw (IO.userError "Could not load America/New_York")
+
+private def wall (month day hour minute : Nat) : DateTime :=
+  { year := 2024, month := month.toUInt8, day := day.toUInt8, hour := hour.toUInt8,
+    minute := minute.toUInt8, second := 0, nanosecond := 0 }
+
+test "wall times are classified against transitions" := do
+  let tz ← newYork
+  (← tz.resolveLocal (wall 7 1 12 0)) ≡ .unique (Timestamp.fromSeconds 1719849600)
+  -- 2024-03-10 02:30 is skipped
+  (← tz.resolveLocal (wall 3 10 2 30)) ≡
+    .skipped (Timestamp.fromSeconds 1710055800) (Timestamp.fromSeconds 1710052200)
+  -- 2024-11-03 01:30 happens twice
+  (← tz.resolveLocal (wall 11 3 1 30)) ≡
+    .ambiguous (Timestamp.fromSeconds 1730611800) (Timestamp.fromSeconds 1730615400)
+
+test "policies pick the expected instant" := do
+  let tz ← newYork
+  let dts := #[wall 3 10 2 30, wall 11 3 1 30]
+  let secs (p : DstPolicy) : IO (Array (Option Int)) := do
+    return (← DateTime.toTimestampsInTimezone dts tz p).map (·.map (·.seconds))
+  (← secs .compatible) ≡ #[some 1710055800, some 1730611800]
+  (← secs .earlier) ≡ #[some 1710052200, some 1730611800]
+  (← secs .later) ≡ #[some 1710055800, some 1730615400]
+  (← secs .reject) ≡ #[none, none]
+
+test "compatible policy matches toTimestampInTimezone" := do
+  let tz ← newYork
+  for dt in #[wall 1 15 8 0, wall 3 10 2 30, wall 11 3 1 30] do
+    let ts ← (dt.toTimestampInTimezoneWith tz .compatible).toIO
+    ts ≡ (← dt.toTimestampInTimezone tz)
+
+test "reject policy fails on skipped times" := do
+  let r ← ((wall 3 10 2 30).toTimestampInTimezoneWith (← newYork) .reject).run
+  shouldSatisfy (match r with | .error _ => true | .ok _ => false) "rejected"
+
+end DstPolicyTests
+
+-- ============================================================================
+-- Clock Snapshot Tests
+-- ============================================================================
+
+namespace ClockSnapshotTests
+
+testSuite "Chronos.ClockSnapshot"
+
+test "mapping carries nanoseconds across seconds" := do
+  let s : ClockSnapshot := { monotonic := ⟨100, 900000000⟩, wall := ⟨1700000000, 200000000⟩,
+                             uncertainty := Duration.zero }
+  s.toTimestamp ⟨100, 900000000⟩ ≡ ⟨1700000000, 200000000⟩
+  s.toTimestamp ⟨101, 800000000⟩ ≡ ⟨1700000001, 100000000⟩
+  s.toTimestamp ⟨100, 0⟩ ≡ ⟨1699999999, 300000000⟩
+  s.toTimestamps #[⟨102, 900000000⟩] ≡ #[⟨1700000002, 200000000⟩]
+
+test "mapped times track the wall clock" := do
+  let s ← ClockSnapshot.take
+  let mapped := s.toTimestamp (← MonotonicTime.now)
+  let wall ← Timestamp.now
+  shouldSatisfy ((wall.diff mapped).natAbs < 50000000) "within 50ms"
+
+test "a consistent snapshot is kept by refresh" := do
+  let s ← ClockSnapshot.take
+  let r ← s.refresh (Duration.fromMilliseconds 50)
+  r ≡ s
+
+test "a stepped wall clock triggers a new snapshot" := do
+  let s ← ClockSnapshot.take
+  let skewed := { s with wall := s.wall.addSeconds 5 }
+  (← skewed.stepped) ≡ true
+
+end ClockSnapshotTests
+
+-- ============================================================================
+-- Segment Tests
+-- ============================================================================
+
+namespace SegmentTests
+
+testSuite "Chronos.Segment"
+
+private def tempPath : IO System.FilePath := do
+  let (h, path) ← IO.FS.createTempFile
+  h.flush
+  IO.FS.removeFile path
+  return path
+
+private def ts (i : Nat) : Timestamp := Timestamp.fromSeconds (1700000000 + (i : Int))
+
+private def writeEvents (path : System.FilePath) (n : Nat) : IO Unit := do
+  let w ← SegmentWriter.openFile path (blockSize := 256)
+  for i in [0:n] do
+    w.append (ts i) s!"event {i}".toUTF8
+  w.close
+
+test "records round-trip across blocks" := do
+  let path ← tempPath
+  writeEvents path 100
+  let r ← SegmentReader.openFile path
+  shouldSatisfy ((← r.blockCount) > 1) "spans several blocks"
+  let all ← r.since Timestamp.epoch
+  all.size ≡ 100
+  all.map (·.time) ≡ (Array.range 100).map ts
+  String.fromUTF8! all[42]!.payload ≡ "event 42"
+  (← r.bounds) ≡ some (ts 0, ts 99)
+  IO.FS.removeFile path
+
+test "seek and range use the block index" := do
+  let path ← tempPath
+  writeEvents path 100
+  let r ← SegmentReader.openFile path
+  ((← r.since (ts 90)).map (·.time)) ≡ (Array.range 10).map (ts <| 90 + ·)
+  ((← r.range (ts 10) (ts 13)).map (·.time)) ≡ #[ts 10, ts 11, ts 12]
+  (← r.since (ts 100)).size ≡ 0
+  IO.FS.removeFile path
+
+test "reopened writers append in order" := do
+  let path ← tempPath
+  writeEvents path 10
+  let w ← SegmentWriter.openFile path
+  let r ← (w.append (ts 5) ByteArray.empty).toBaseIO
+  shouldSatisfy (match r with | .error _ => true | .ok _ => false) "rejects going backwards"
+  w.append (ts 10) "late".toUTF8
+  w.close
+  let all ← (← SegmentReader.openFile path).since Timestamp.epoch
+  all.size ≡ 11
+  IO.FS.removeFile path
+
+test "reopening drops a torn block" := do
+  let path ← tempPath
+  writeEvents path 10
+  -- A crash part-way through writing a block
+  let h ← IO.FS.Handle.mk path .append
+  h.write ((Segment.encodeBlock 256 #[(0, "torn".toUTF8)]).extract 0 100)
+  h.flush
+  let w ← SegmentWriter.openFile path
+  w.append (ts 10) "after".toUTF8
+  w.close
+  let all ← (← SegmentReader.openFile path).since Timestamp.epoch
+  all.size ≡ 11
+  String.fromUTF8! all[10]!.payload ≡ "after"
+  IO.FS.removeFile path
+
+test "timestamps outside the int64 range are rejected" := do
+  let path ← tempPath
+  let w ← SegmentWriter.openFile path (blockSize := 256)
+  w.append (ts 0) "a".toUTF8
+  -- Year 2300 does not fit in int64 nanoseconds and would wrap on disk
+  let r ← (w.append (Timestamp.fromSeconds 10413792000) "b".toUTF8).toBaseIO
+  shouldSatisfy (match r with | .error _ => true | .ok _ => false) "rejects out-of-range timestamps"
+  w.close
+  (← (← SegmentReader.openFile path).since Timestamp.epoch).size ≡ 1
+  IO.FS.removeFile path
+
+test "closed writers reject appends" := do
+  let path ← tempPath
+  let w ← SegmentWriter.openFile path (blockSize := 256)
+  w.append (ts 0) "a".toUTF8
+  w.close
+  w.close
+  let r ← (w.append (ts 1) "b".toUTF8).toBaseIO
+  shouldSatisfy (match r with | .error _ => true | .ok _ => false) "append after close fails"
+  (← (← SegmentReader.openFile path).since Timestamp.epoch).size ≡ 1
+  IO.FS.removeFile path
+
+end SegmentTests
+
+-- ============================================================================
+-- Log Seek Tests
+-- ============================================================================
+
+namespace LogSeekTests
+
+testSuite "Chronos.LogSeek"
+
+private def stamp (minute second : Nat) : String :=
+  let pad (n : Nat) := if n < 10 then s!"0{n}" else toString n
+  s!"2024-03-10T14:{pad minute}:{pad second}.250Z"
+
+private def timeAt (minute second : Nat) : Timestamp :=
+  Timestamp.fromSeconds (1710079200 + (minute * 60 + second : Nat))
+
+/-- A log with one entry every 10 seconds from 14:00 to 14:09:50, every
+    fifth entry followed by a continuation line. -/
+private def writeLog : IO System.FilePath := do
+  let (h, path) ← IO.FS.createTempFile
+  for k in [0:60] do
+    h.putStrLn s!"{stamp (k / 6) (k % 6 * 10)} INFO request {k}"
+    if k % 5 == 0 then h.putStrLn s!"    at handler {k}"
+  h.flush
+  return path
+
+test "ISO line heads parse" := do
+  LogFile.parseIsoHead "2024-03-10T14:03:05.250Z rest".toUTF8 ≡ some ⟨1710079385, 250000000⟩
+  LogFile.parseIsoHead "2024-03-10 14:03:05,5 rest".toUTF8 ≡ some ⟨1710079385, 500000000⟩
+  LogFile.parseIsoHead "    at handler".toUTF8 ≡ none
+
+test "seek finds the first line at or after a time" := do
+  let path ← writeLog
+  let log ← LogFile.openFile path
+  let content ← IO.FS.readFile path
+  let off ← log.seek (timeAt 3 0)
+  shouldSatisfy ((content.toUTF8.extract off (off + 24)) == (stamp 3 0).toUTF8) "lands on 14:03:00"
+  (← log.seek (timeAt 20 0)) ≡ log.size
+  (← log.seek (timeAt 0 0)) ≡ 0
+  IO.FS.removeFile path
+
+test "range streams matching lines with continuations" := do
+  let path ← writeLog
+  let log ← LogFile.openFile path
+  let lines ← log.linesIn (timeAt 3 0) (timeAt 3 30)
+  lines ≡ #[s!"{stamp 3 0} INFO request 18", s!"{stamp 3 10} INFO request 19",
+            s!"{stamp 3 20} INFO request 20", "    at handler 20"]
+  -- Small chunks still yield whole lines
+  let out ← IO.mkRef (#[] : Array String)
+  let (a, b) ← log.rangeOffsets (timeAt 0 0) (timeAt 10 0)
+  log.forLinesBetween a b (fun l => out.modify (·.push l)) (chunkSize := 7)
+  (← out.get).size ≡ 72
+  IO.FS.removeFile path
+
+test "CRLF line endings are stripped" := do
+  let (h, path) ← IO.FS.createTempFile
+  for k in [0:3] do
+    h.putStr s!"{stamp 0 (k * 10)} INFO crlf {k}\r\n"
+  h.flush
+  let log ← LogFile.openFile path
+  let lines ← log.linesIn (timeAt 0 0) (timeAt 0 30)
+  lines ≡ #[s!"{stamp 0 0} INFO crlf 0", s!"{stamp 0 10} INFO crlf 1", s!"{stamp 0 20} INFO crlf 2"]
+  IO.FS.removeFile path
+
+end LogSeekTests
+
+-- ============================================================================
+-- CSV timestamp transform tests
+-- ============================================================================
+
+namespace CsvTimestampsTests
+
+testSuite "Chronos.CsvTimestamps"
+
+private def parse (s : String) : Option Timestamp :=
+  CsvTimestamps.parseRfc3339 s.toUTF8 0 s.utf8ByteSize
+
+test "RFC 3339 fields parse from bytes" := do
+  parse "2024-03-10T14:03:05Z" ≡ some ⟨1710079385, 0⟩
+  parse "2024-03-10 14:03:05.25" ≡ some ⟨1710079385, 250000000⟩
+  parse "2024-03-10T10:03:05-04:00" ≡ some ⟨1710079385, 0⟩
+  parse "\"2024-03-10T19:33:05+0530\"" ≡ some ⟨1710079385, 0⟩
+  parse "2024-02-30T00:00:00Z" ≡ none
+  parse "2024-03-10T14:03:05 extra" ≡ none
+  parse "n/a" ≡ none
+  -- Truncated offsets at the end of the buffer
+  parse "2024-03-10T14:03:05+1" ≡ none
+  parse "2024-03-10T14:03:05+01" ≡ none
+  parse "2024-03-10T14:03:05+01:" ≡ none
+  -- Out-of-range offsets and empty fractions
+  parse "2024-03-10T14:03:05+99:99" ≡ none
+  parse "2024-03-10T14:03:05+24:00" ≡ none
+  parse "2024-03-10T14:03:05.Z" ≡ none
+  parse "2024-03-10T14:03:05," ≡ none
+
+private def sample : String :=
+  "id,at,note\n" ++
+  "1,2024-03-10T14:03:05Z,\"a, b\"\n" ++
+  "2,2024-03-10T14:03:05.5-01:00,plain\r\n" ++
+  "3,bad,x\n" ++
+  "4,2024-03-10T23:59:59.123456Z,last"
+
+test "columns are rewritten and other fields copied" := do
+  let (out, stats) ← CsvTimestamps.transformString { columns := #[1] } sample
+  out ≡ "id,at,note\n" ++
+    "1,2024-03-10T14:03:05Z,\"a, b\"\n" ++
+    "2,2024-03-10T15:03:05.500Z,plain\r\n" ++
+    "3,bad,x\n" ++
+    "4,2024-03-10T23:59:59.123456Z,last"
+  stats.rows ≡ 4
+  stats.converted ≡ 3
+  stats.failed ≡ 1
+  stats.bytesIn ≡ sample.utf8ByteSize
+  stats.bytesOut ≡ out.utf8ByteSize
+
+test "output can be rendered in a zone" := do
+  let some tz ← Timezone.fixed 19800 | throw (IO.userError "fixed zone")
+  let (out, _) ← CsvTimestamps.transformString { columns := #[1], zone := some tz } sample
+  shouldSatisfy ((out.splitOn "\n")[1]! == "1,2024-03-10T19:33:05+05:30,\"a, b\"") "shifted to +05:30"
+  shouldSatisfy ((out.splitOn "\n")[4]! == "4,2024-03-11T05:29:59.123456+05:30,last") "crosses midnight"
+
+test "epoch formats" := do
+  let csv := "2024-03-10T14:03:05.250Z,2024-03-10T14:03:05.250Z\n"
+  let (out, _) ← CsvTimestamps.transformString
+    { columns := #[0], hasHeader := false, format := .epochMillis } csv
+  out ≡ "1710079385250,2024-03-10T14:03:05.250Z\n"
+  let (out, _) ← CsvTimestamps.transformString
+    { columns := #[0, 1], hasHeader := false, format := .epochSeconds } csv
+  out ≡ "1710079385,1710079385\n"
+
+test "quoted newlines stay inside their record" := do
+  let csv := "id,note,at\n1,\"two\nlines\",2024-03-10T14:03:05.5-01:00\n2,x,2024-03-10T14:03:05+1"
+  for chunkSize in [5, 65536] do
+    let (out, stats) ← CsvTimestamps.transformString { columns := #[2], chunkSize } csv
+    out ≡ "id,note,at\n1,\"two\nlines\",2024-03-10T15:03:05.500Z\n2,x,2024-03-10T14:03:05+1"
+    stats.rows ≡ 2
+    stats.converted ≡ 1
+    stats.failed ≡ 1
+
+test "small chunks give the same output" := do
+  let cfg : CsvTimestamps.Config := { columns := #[1] }
+  let (whole, _) ← CsvTimestamps.transformString cfg sample
+  let (chunked, stats) ← CsvTimestamps.transformString { cfg with chunkSize := 5 } sample
+  chunked ≡ whole
+  stats.rows ≡ 4
+  shouldSatisfy (stats.rowsPerSecond ≥ 0) "throughput is reported"
+
+end CsvTimestampsTests
+
+-- ============================================================================
+-- Clock tests
+-- ============================================================================
+
+namespace ClockTests
+
+testSuite "Chronos.Clock"
+
+private def secs (n : Int) : Duration := Duration.fromSeconds n
+
+test "virtual sleeps advance time instantly" := do
+  let c ← VirtualClock.new (Timestamp.fromSeconds 1000)
+  Clock.sleep c (secs 3600)
+  (← c.read) ≡ Timestamp.fromSeconds 4600
+  Clock.sleepUntil c (Timestamp.fromSeconds 5000)
+  (← c.read) ≡ Timestamp.fromSeconds 5000
+  -- Sleeping until a past time does not move the clock
+  Clock.sleepUntil c (Timestamp.fromSeconds 10)
+  (← c.read) ≡ Timestamp.fromSeconds 5000
+  (← Clock.elapsed c (Timestamp.fromSeconds 1000)) ≡ secs 4000
+
+test "deadlines and polling follow the clock" := do
+  let c ← VirtualClock.new
+  let dl ← Clock.deadline c (secs 10)
+  (← Clock.expired c dl) ≡ false
+  c.advance (secs 4)
+  (← Clock.remaining c dl) ≡ secs 6
+  -- Condition never holds: gives up after the timeout
+  let calls ← IO.mkRef 0
+  let never : IO Bool := do
+    calls.modify (· + 1)
+    return false
+  let ok ← Clock.pollUntil c (secs 6) (secs 2) never
+  ok ≡ false
+  (← calls.get) ≡ 4
+  (← Clock.expired c dl) ≡ true
+  -- Condition becomes true on the third check
+  calls.set 0
+  let third : IO Bool := do
+    calls.modify (· + 1)
+    return (← calls.get) ≥ 3
+  let ok ← Clock.pollUntil c (secs 60) (secs 1) third
+  ok ≡ true
+
+test "timers tick at a fixed rate" := do
+  let c ← VirtualClock.new (Timestamp.fromSeconds 100)
+  let ticks ← IO.mkRef (#[] : Array (Nat × Int))
+  Clock.every c (secs 30) 4 fun k _ => do
+    ticks.modify (·.push (k, (← c.read).seconds))
+    -- Work that takes longer than a tick makes the next one run late
+    if k == 1 then c.advance (secs 45)
+  (← ticks.get) ≡ #[(0, 100), (1, 130), (2, 175), (3, 190)]
+
+test "recurrences run at their instants" := do
+  let c ← VirtualClock.new (Timestamp.fromSeconds 1710028800)
+  let tz ← Timezone.utc
+  let r ← match RRule.parse "FREQ=DAILY;COUNT=5" with
+    | .ok r => pure r
+    | .error e => throw (IO.userError e)
+  let start : DateTime :=
+    { year := 2024, month := 3, day := 10, hour := 9, minute := 0, second := 0, nanosecond := 0 }
+  let seen ← IO.mkRef (#[] : Array Int)
+  let it ← Clock.runRecurring c (r.iter start) tz 3 fun _ t => do
+    seen.modify (·.push ((← c.read).seconds - t.seconds))
+  (← seen.get) ≡ #[0, 0, 0]
+  (← c.read) ≡ Timestamp.fromSeconds (1710061200 + 2 * 86400)
+  (it.take 5).size ≡ 2
+
+test "blocked virtual sleeps wait for advance" := do
+  let c ← VirtualClock.new (autoAdvance := false)
+  let sleeper ← IO.asTask (Clock.sleepUntil c (Timestamp.fromSeconds 5))
+  c.advance (secs 2)
+  c.advance (secs 3)
+  match ← IO.wait sleeper with
+  | .ok () => pure ()
+  | .error e => throw e
+  (← c.read) ≡ Timestamp.fromSeconds 5
+
+test "real clocks sleep for real" := do
+  let start ← Clock.now MonotonicClock.mk
+  Clock.sleep MonotonicClock.mk (Duration.fromMilliseconds 2)
+  shouldSatisfy ((← Clock.elapsed MonotonicClock.mk start) ≥ Duration.fromMilliseconds 2)
+    "monotonic sleep waited"
+  let wall ← Clock.now RealtimeClock.mk
+  shouldSatisfy (wall.seconds > 1700000000) "realtime reads the wall clock"
+
+end ClockTests
+
+-- ============================================================================
+-- Resample tests
+-- ============================================================================
+
+namespace ResampleTests
+
+testSuite "Chronos.Resample"
+
+private def ts (s : Int) : Timestamp := Timestamp.fromSeconds s
+
+private def series : Array (Timestamp × Float) :=
+  #[(ts 0, 1), (ts 5, 3), (ts 12, 5), (ts 41, 9)]
+
+private def width : Duration := Duration.fromSeconds 10
+
+test "aggregations per bin" := do
+  let run (a : Aggregation) := (Resample.samples series width a).map (·.2)
+  run .last ≡ #[some 3, some 5, none, none, some 9]
+  run .mean ≡ #[some 2, some 5, none, none, some 9]
+  run .min ≡ #[some 1, some 5, none, none, some 9]
+  run .max ≡ #[some 3, some 5, none, none, some 9]
+  run .count ≡ #[some 2, some 1, none, none, some 1]
+  (Resample.samples series width .last).map (·.1) ≡ #[ts 0, ts 10, ts 20, ts 30, ts 40]
+
+test "time-weighted average holds values across bins" := do
+  -- [10, 20): 3 holds until 12, then 5; [40, 50): 5 until 41, then 9
+  (Resample.samples series width .timeWeighted).map (·.2) ≡
+    #[some 2, some 4.6, none, none, some 8.6]
+
+test "fill policies" := do
+  let fills (f : FillPolicy) := (Resample.samples series width .last f).map (·.2)
+  fills .previous ≡ #[some 3, some 5, some 5, some 5, some 9]
+  fills .linear ≡ #[some 3, some 5, some (5 + 4 * (8 / 29)), some (5 + 4 * (18 / 29)), some 9]
+  fills .null ≡ #[some 3, some 5, none, none, some 9]
+
+test "columns match pairs" := do
+  Resample.columns (series.map (·.1)) (series.map (·.2)) width .mean .linear ≡
+    Resample.samples series width .mean .linear
+
+test "streaming emits bins as they complete" := do
+  let some r := Resampler.new width .last .previous | throw (IO.userError "width")
+  let mut r := r
+  let mut emitted : Array (Array (Timestamp × Option Float)) := #[]
+  for (t, v) in series do
+    let (r', out) := r.push t v
+    r := r'
+    emitted := emitted.push out
+  emitted.map (·.size) ≡ #[0, 0, 1, 3]
+  -- Late samples before the open bin are dropped
+  let (r, out) := r.push (ts 3) 7
+  out.size ≡ 0
+  r.dropped ≡ 1
+  r.finish (some (ts 70)) ≡ #[(ts 40, some 9), (ts 50, some 9), (ts 60, some 9)]
+  shouldSatisfy (Resampler.new Duration.zero .mean).isNone "width must be positive"
+
+end ResampleTests
+
 -- ============================================================================
 -- Main
 -- ============================================================================
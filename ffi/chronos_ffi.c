@@ -10,6 +10,11 @@
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /* ============================================================================
  * Platform detection for timezone APIs
@@ -245,6 +250,45 @@ LEAN_EXPORT lean_obj_res chronos_monotonic_now(lean_obj_arg world) {
     return lean_io_result_mk_ok(mk_pair(seconds, nanos));
 }
 
+/* ============================================================================
+ * chronos_clock_snapshot : UInt32 -> IO ((Int × UInt32) × (Int × UInt32) × UInt32)
+ *
+ * Read the monotonic and realtime clocks back-to-back `reads` times and
+ * keep the tightest pairing: the realtime read bracketed by the two
+ * closest monotonic reads. Returns (monotonic midpoint, realtime, width of
+ * the bracket in nanoseconds).
+ * ============================================================================ */
+
+static int64_t timespec_ns(const struct timespec* ts) {
+    return (int64_t)ts->tv_sec * 1000000000 + ts->tv_nsec;
+}
+
+LEAN_EXPORT lean_obj_res chronos_clock_snapshot(uint32_t reads, lean_obj_arg world) {
+    if (reads == 0) reads = 1;
+    struct timespec m1, w, m2, best_w;
+    int64_t best_width = INT64_MAX, best_mono = 0;
+
+    for (uint32_t k = 0; k < reads; k++) {
+        if (clock_gettime(CLOCK_MONOTONIC, &m1) != 0 ||
+            clock_gettime(CLOCK_REALTIME, &w) != 0 ||
+            clock_gettime(CLOCK_MONOTONIC, &m2) != 0) {
+            return mk_io_error("clock_gettime failed");
+        }
+        int64_t a = timespec_ns(&m1), b = timespec_ns(&m2);
+        if (b - a < best_width) {
+            best_width = b - a;
+            best_mono = a + (b - a) / 2;
+            best_w = w;
+        }
+    }
+
+    lean_obj_res mono = mk_pair(lean_int64_to_int(best_mono / 1000000000),
+                                lean_box_uint32((uint32_t)(best_mono % 1000000000)));
+    lean_obj_res wall = mk_pair(lean_int64_to_int(best_w.tv_sec), lean_box_uint32((uint32_t)best_w.tv_nsec));
+    uint32_t width = best_width > UINT32_MAX ? UINT32_MAX : (uint32_t)best_width;
+    return lean_io_result_mk_ok(mk_pair(mono, mk_pair(wall, lean_box_uint32(width))));
+}
+
 /* ============================================================================
  * chronos_weekday : Int64 → IO UInt8
  *
@@ -288,6 +332,713 @@ LEAN_EXPORT lean_obj_res chronos_day_of_year(lean_obj_arg seconds_obj, lean_obj_
     return lean_io_result_mk_ok(lean_box(day_of_year));
 }
 
+/* ============================================================================
+ * Civil date helpers
+ *
+ * Proleptic Gregorian conversions between days since 1970-01-01 and
+ * (year, month, day), matching DateTime.daysFromCivil/civilFromDays.
+ * ============================================================================ */
+
+static int64_t floor_div(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+    return q;
+}
+
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = floor_div(y, 400);
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t* y, unsigned* m, unsigned* d) {
+    z += 719468;
+    int64_t era = floor_div(z, 146097);
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = (int64_t)yoe + era * 400 + (*m <= 2);
+}
+
+/* ============================================================================
+ * TZif zone data
+ *
+ * Zone files (RFC 8536) are parsed into a read-only view: the arrays point
+ * into the original bytes (embedded snapshot or file mapping) and are
+ * decoded on access, so loading a zone copies nothing.
+ * ============================================================================ */
+
+typedef struct PosixTz PosixTz;
+
+typedef struct {
+    const uint8_t* base;        /* Start of the TZif bytes */
+    size_t len;
+    int mapped;                 /* 1 if base is a file mapping to release */
+    uint32_t timecnt;
+    uint32_t typecnt;
+    uint32_t charcnt;
+    int time_size;              /* 8 for v2+ data, 4 for v1-only files */
+    const uint8_t* times;       /* timecnt transition times, big-endian */
+    const uint8_t* idxs;        /* timecnt local time type indices */
+    const uint8_t* types;       /* typecnt 6-byte ttinfo records */
+    const uint8_t* chars;       /* charcnt abbreviation bytes */
+    const char* footer;         /* POSIX TZ string (v2+), not NUL-terminated */
+    size_t footer_len;
+    PosixTz* rule;              /* Parsed footer (or standalone rule), or NULL */
+} TzData;
+
+/* Local time type in effect at an instant. */
+typedef struct {
+    int32_t utoff;              /* Seconds east of UTC */
+    int isdst;
+    const char* abbr;           /* NUL-terminated abbreviation */
+} TzInfo;
+
+static uint32_t be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int64_t be64(const uint8_t* p) {
+    return (int64_t)(((uint64_t)be32(p) << 32) | be32(p + 4));
+}
+
+static int64_t tzdata_time(const TzData* d, uint32_t i) {
+    return d->time_size == 8 ? be64(d->times + 8 * (size_t)i)
+                             : (int64_t)(int32_t)be32(d->times + 4 * (size_t)i);
+}
+
+static TzInfo tzdata_type_info(const TzData* d, uint8_t type) {
+    const uint8_t* rec = d->types + 6 * (size_t)type;
+    TzInfo info;
+    info.utoff = (int32_t)be32(rec);
+    info.isdst = rec[4] != 0;
+    info.abbr = (const char*)d->chars + rec[5];
+    return info;
+}
+
+/* ============================================================================
+ * POSIX TZ rules
+ *
+ * A POSIX TZ string ("EST5EDT,M3.2.0,M11.1.0") describes a zone with a
+ * standard offset and optionally a yearly DST rule. It is the footer of
+ * TZif v2+ files, where it extends the zone past its last transition, and
+ * can also be used on its own. A year's two transitions are computed with
+ * civil-date arithmetic; recent years are cached per thread.
+ * ============================================================================ */
+
+/* Transition date: Jn (1-365, Feb 29 never counted), n (0-365, counting
+ * Feb 29) or Mm.w.d (day d of week w of month m, w = 5 meaning last). */
+typedef struct {
+    char kind;                  /* 'J', 'D' or 'M' */
+    int n;                      /* Day for 'J' and 'D' */
+    int m, w, d;                /* Month, week, weekday for 'M' */
+    int32_t time;               /* Local time of the transition, seconds */
+} PosixRuleDate;
+
+struct PosixTz {
+    uint64_t id;                /* Unique per parsed rule, keys the year cache */
+    char* spec;                 /* The TZ string, NUL-terminated */
+    char std_abbr[16];
+    char dst_abbr[16];
+    int32_t std_off;            /* Seconds east of UTC */
+    int32_t dst_off;
+    int has_dst;
+    PosixRuleDate start, end;   /* DST start (in standard time) and end (in DST) */
+};
+
+static uint64_t g_posix_next_id = 0;
+
+static const char* posix_parse_abbr(const char* p, char out[16]) {
+    size_t n = 0;
+    if (*p == '<') {
+        p++;
+        while (*p && *p != '>') {
+            if (!(isalnum((unsigned char)*p) || *p == '+' || *p == '-')) return NULL;
+            if (n < 15) out[n++] = *p;
+            p++;
+        }
+        if (*p != '>') return NULL;
+        p++;
+    } else {
+        while (isalpha((unsigned char)*p)) {
+            if (n < 15) out[n++] = *p;
+            p++;
+        }
+    }
+    out[n] = '\0';
+    return n >= 3 ? p : NULL;
+}
+
+/* [+|-]hh[:mm[:ss]] with hours up to 167 (RFC 8536 extension). */
+static const char* posix_parse_hms(const char* p, int32_t* out) {
+    int sign = 1;
+    if (*p == '+') p++;
+    else if (*p == '-') { sign = -1; p++; }
+    if (!isdigit((unsigned char)*p)) return NULL;
+    int32_t h = 0, m = 0, s = 0;
+    for (int k = 0; k < 3 && isdigit((unsigned char)*p); k++) h = h * 10 + (*p++ - '0');
+    if (h > 167) return NULL;
+    if (*p == ':') {
+        p++;
+        if (!isdigit((unsigned char)p[0]) || !isdigit((unsigned char)p[1])) return NULL;
+        m = (p[0] - '0') * 10 + (p[1] - '0');
+        p += 2;
+        if (*p == ':') {
+            p++;
+            if (!isdigit((unsigned char)p[0]) || !isdigit((unsigned char)p[1])) return NULL;
+            s = (p[0] - '0') * 10 + (p[1] - '0');
+            p += 2;
+        }
+        if (m > 59 || s > 59) return NULL;
+    }
+    *out = sign * (h * 3600 + m * 60 + s);
+    return p;
+}
+
+static const char* posix_parse_int(const char* p, int lo, int hi, int* out) {
+    if (!isdigit((unsigned char)*p)) return NULL;
+    int v = 0;
+    for (int k = 0; k < 3 && isdigit((unsigned char)*p); k++) v = v * 10 + (*p++ - '0');
+    if (v < lo || v > hi) return NULL;
+    *out = v;
+    return p;
+}
+
+static const char* posix_parse_date(const char* p, PosixRuleDate* r) {
+    if (*p == 'J') {
+        r->kind = 'J';
+        p = posix_parse_int(p + 1, 1, 365, &r->n);
+    } else if (*p == 'M') {
+        r->kind = 'M';
+        p = posix_parse_int(p + 1, 1, 12, &r->m);
+        if (!p || *p != '.') return NULL;
+        p = posix_parse_int(p + 1, 1, 5, &r->w);
+        if (!p || *p != '.') return NULL;
+        p = posix_parse_int(p + 1, 0, 6, &r->d);
+    } else {
+        r->kind = 'D';
+        p = posix_parse_int(p, 0, 365, &r->n);
+    }
+    if (!p) return NULL;
+    r->time = 2 * 3600;
+    if (*p == '/') p = posix_parse_hms(p + 1, &r->time);
+    return p;
+}
+
+/* Parse a POSIX TZ string. Returns NULL if it is malformed. */
+static PosixTz* posix_parse(const char* spec) {
+    PosixTz* r = (PosixTz*)calloc(1, sizeof(PosixTz));
+    if (!r) return NULL;
+    int32_t off;
+    const char* p = posix_parse_abbr(spec, r->std_abbr);
+    if (p) p = posix_parse_hms(p, &off);
+    if (!p) goto fail;
+    /* POSIX offsets are west of UTC */
+    r->std_off = -off;
+    r->dst_off = r->std_off;
+    if (*p) {
+        p = posix_parse_abbr(p, r->dst_abbr);
+        if (!p) goto fail;
+        r->has_dst = 1;
+        r->dst_off = r->std_off + 3600;
+        if (*p && *p != ',') {
+            p = posix_parse_hms(p, &off);
+            if (!p) goto fail;
+            r->dst_off = -off;
+        }
+        if (*p == ',') {
+            p = posix_parse_date(p + 1, &r->start);
+            if (!p || *p != ',') goto fail;
+            p = posix_parse_date(p + 1, &r->end);
+            if (!p) goto fail;
+        } else {
+            /* No rule: the US rules, as libc assumes */
+            r->start = (PosixRuleDate){ 'M', 0, 3, 2, 0, 2 * 3600 };
+            r->end = (PosixRuleDate){ 'M', 0, 11, 1, 0, 2 * 3600 };
+        }
+        if (*p) goto fail;
+    }
+    r->spec = strdup(spec);
+    if (!r->spec) goto fail;
+    r->id = __atomic_add_fetch(&g_posix_next_id, 1, __ATOMIC_RELAXED);
+    return r;
+fail:
+    free(r);
+    return NULL;
+}
+
+/* A rule with a constant offset (seconds east of UTC) and no DST. The
+ * abbreviation follows tzdata's numeric style ("+0530", "-03"). */
+static PosixTz* posix_fixed(int32_t offset) {
+    PosixTz* r = (PosixTz*)calloc(1, sizeof(PosixTz));
+    if (!r) return NULL;
+    int32_t a = offset < 0 ? -offset : offset;
+    int h = a / 3600, m = a % 3600 / 60, sec = a % 60;
+    char sign = offset < 0 ? '-' : '+';
+    if (sec) snprintf(r->std_abbr, sizeof(r->std_abbr), "%c%02d%02d%02d", sign, h, m, sec);
+    else if (m) snprintf(r->std_abbr, sizeof(r->std_abbr), "%c%02d%02d", sign, h, m);
+    else snprintf(r->std_abbr, sizeof(r->std_abbr), "%c%02d", sign, h);
+    r->std_off = offset;
+    r->dst_off = offset;
+    char spec[64];
+    /* POSIX offsets are west of UTC */
+    snprintf(spec, sizeof(spec), "<%s>%c%d:%02d:%02d", r->std_abbr, offset > 0 ? '-' : '+', h, m, sec);
+    r->spec = strdup(spec);
+    if (!r->spec) {
+        free(r);
+        return NULL;
+    }
+    r->id = __atomic_add_fetch(&g_posix_next_id, 1, __ATOMIC_RELAXED);
+    return r;
+}
+
+static void posix_free(PosixTz* r) {
+    if (!r) return;
+    free(r->spec);
+    free(r);
+}
+
+static int is_leap_year(int64_t y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+/* Epoch day of a rule date in year y. */
+static int64_t posix_rule_day(const PosixRuleDate* r, int64_t y) {
+    int64_t jan1 = days_from_civil(y, 1, 1);
+    switch (r->kind) {
+    case 'J':
+        return jan1 + r->n - 1 + (is_leap_year(y) && r->n >= 60);
+    case 'D':
+        return jan1 + r->n;
+    default: {
+        static const unsigned mdays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        int64_t first = days_from_civil(y, (unsigned)r->m, 1);
+        /* 1970-01-01 was a Thursday (weekday 4) */
+        int64_t wday = ((first + 4) % 7 + 7) % 7;
+        int64_t day = first + (r->d - wday + 7) % 7 + 7 * (int64_t)(r->w - 1);
+        int64_t dim = mdays[r->m - 1] + (r->m == 2 && is_leap_year(y));
+        while (day >= first + dim) day -= 7;
+        return day;
+    }
+    }
+}
+
+/* UTC instants of year y's DST start and end, cached per thread. */
+typedef struct {
+    uint64_t id;
+    int64_t year;
+    int64_t start, end;
+} PosixYearCache;
+
+#define POSIX_YEAR_CACHE_SIZE 4
+static _Thread_local PosixYearCache g_posix_years[POSIX_YEAR_CACHE_SIZE];
+static _Thread_local unsigned g_posix_years_next;
+
+static void posix_year(const PosixTz* r, int64_t y, int64_t* start, int64_t* end) {
+    for (unsigned k = 0; k < POSIX_YEAR_CACHE_SIZE; k++) {
+        const PosixYearCache* c = &g_posix_years[k];
+        if (c->id == r->id && c->year == y) {
+            *start = c->start;
+            *end = c->end;
+            return;
+        }
+    }
+    *start = posix_rule_day(&r->start, y) * 86400 + r->start.time - r->std_off;
+    *end = posix_rule_day(&r->end, y) * 86400 + r->end.time - r->dst_off;
+    PosixYearCache* c = &g_posix_years[g_posix_years_next++ % POSIX_YEAR_CACHE_SIZE];
+    c->id = r->id;
+    c->year = y;
+    c->start = *start;
+    c->end = *end;
+}
+
+static int64_t year_of(int64_t t) {
+    int64_t y;
+    unsigned m, d;
+    civil_from_days(floor_div(t, 86400), &y, &m, &d);
+    return y;
+}
+
+static TzInfo posix_lookup(const PosixTz* r, int64_t t) {
+    TzInfo info = { r->std_off, 0, r->std_abbr };
+    if (!r->has_dst) return info;
+    int64_t start, end;
+    posix_year(r, year_of(t + r->std_off), &start, &end);
+    /* Southern-hemisphere rules have DST across the new year */
+    int dst = start < end ? (start <= t && t < end) : !(end <= t && t < start);
+    if (dst) {
+        info.utoff = r->dst_off;
+        info.isdst = 1;
+        info.abbr = r->dst_abbr;
+    }
+    return info;
+}
+
+/* Nearest rule transition strictly after t (forward) or at/before t.
+ * Returns 0 when the rule never changes the offset. */
+static int posix_offset_change(const PosixTz* r, int64_t t, int forward, int64_t* out) {
+    if (!r->has_dst || r->std_off == r->dst_off) return 0;
+    int64_t y = year_of(t + r->std_off);
+    int found = 0;
+    for (int64_t yy = y - 1; yy <= y + 1; yy++) {
+        int64_t c[2];
+        posix_year(r, yy, &c[0], &c[1]);
+        for (int k = 0; k < 2; k++) {
+            int ok = forward ? c[k] > t && (!found || c[k] < *out)
+                             : c[k] <= t && (!found || c[k] > *out);
+            /* Skip coinciding end/start pairs, as in all-year DST rules */
+            if (ok && posix_lookup(r, c[k]).utoff != posix_lookup(r, c[k] - 1).utoff) {
+                *out = c[k];
+                found = 1;
+            }
+        }
+    }
+    return found;
+}
+
+/* Parse TZif bytes into `d`. Returns 0 on success. For v2+ files the
+ * 64-bit data block and footer are used and the v1 block is skipped. */
+static int tzdata_parse(const uint8_t* p, size_t len, TzData* d) {
+    if (len < 44 || memcmp(p, "TZif", 4) != 0) return -1;
+    uint8_t version = p[4];
+    size_t off = 0;
+    int time_size = 4;
+
+    for (;;) {
+        if (len - off < 44 || memcmp(p + off, "TZif", 4) != 0) return -1;
+        const uint8_t* h = p + off;
+        uint32_t isutcnt = be32(h + 20), isstdcnt = be32(h + 24), leapcnt = be32(h + 28);
+        uint32_t timecnt = be32(h + 32), typecnt = be32(h + 36), charcnt = be32(h + 40);
+        size_t body = (size_t)timecnt * (size_t)time_size + timecnt + (size_t)typecnt * 6 +
+                      charcnt + (size_t)leapcnt * (size_t)(time_size + 4) + isstdcnt + isutcnt;
+        if (len - off - 44 < body) return -1;
+
+        if (time_size == 4 && version >= '2') {
+            /* Skip the legacy 32-bit block */
+            off += 44 + body;
+            time_size = 8;
+            continue;
+        }
+        if (typecnt == 0 || charcnt == 0) return -1;
+
+        const uint8_t* q = h + 44;
+        d->base = p;
+        d->len = len;
+        d->mapped = 0;
+        d->timecnt = timecnt;
+        d->typecnt = typecnt;
+        d->charcnt = charcnt;
+        d->time_size = time_size;
+        d->times = q;  q += (size_t)timecnt * (size_t)time_size;
+        d->idxs = q;   q += timecnt;
+        d->types = q;  q += (size_t)typecnt * 6;
+        d->chars = q;  q += charcnt;
+        q += (size_t)leapcnt * (size_t)(time_size + 4) + isstdcnt + isutcnt;
+
+        d->footer = NULL;
+        d->footer_len = 0;
+        const uint8_t* end = p + len;
+        if (time_size == 8 && q < end && *q == '\n') {
+            const uint8_t* nl = memchr(q + 1, '\n', (size_t)(end - q - 1));
+            if (nl) {
+                d->footer = (const char*)(q + 1);
+                d->footer_len = (size_t)(nl - q - 1);
+            }
+        }
+
+        for (uint32_t i = 0; i < timecnt; i++) {
+            if (d->idxs[i] >= typecnt) return -1;
+        }
+        for (uint32_t i = 0; i < typecnt; i++) {
+            if (d->types[6 * i + 5] >= charcnt) return -1;
+        }
+        /* Abbreviations must be NUL-terminated within the block */
+        if (d->chars[charcnt - 1] != '\0') return -1;
+
+        d->rule = NULL;
+        if (d->footer_len > 0 && d->footer_len < 256) {
+            char spec[256];
+            memcpy(spec, d->footer, d->footer_len);
+            spec[d->footer_len] = '\0';
+            d->rule = posix_parse(spec);
+        }
+        return 0;
+    }
+}
+
+/* Index of the last transition at or before t, or -1. */
+static int64_t tzdata_find(const TzData* d, int64_t t) {
+    uint32_t lo = 0, hi = d->timecnt;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (tzdata_time(d, mid) <= t) lo = mid + 1; else hi = mid;
+    }
+    return (int64_t)lo - 1;
+}
+
+/* Whether instants at or after t are governed by the POSIX rule: past the
+ * last transition, or everywhere for a standalone rule. */
+static int tzdata_uses_rule(const TzData* d, int64_t t) {
+    return d->rule && (d->timecnt == 0 || t >= tzdata_time(d, d->timecnt - 1));
+}
+
+/* Local time type in effect at UTC instant t. Before the first transition
+ * the zone uses type 0 (RFC 8536 section 3.2); after the last one, the
+ * footer rule. */
+static TzInfo tzdata_lookup(const TzData* d, int64_t t) {
+    if (tzdata_uses_rule(d, t)) return posix_lookup(d->rule, t);
+    int64_t i = tzdata_find(d, t);
+    return tzdata_type_info(d, i < 0 ? 0 : d->idxs[i]);
+}
+
+/* Offset lookup used by local-to-UTC resolution: seconds east of UTC at a
+ * UTC instant in `zone`. */
+typedef int32_t (*UtcOffsetFn)(const void* zone, int64_t t);
+
+/* Resolve local wall-clock seconds (since 1970-01-01 local) to UTC.
+ * Returns the number of instants that read as `local`: 1 normally, 2 in a
+ * repeated interval (out[0] < out[1]) and 0 in a skipped one. In a skipped
+ * interval out[0] is the mktime-style result using the offset in effect
+ * before the gap (shifted forward) and out[1] uses the offset after it
+ * (shifted backward). */
+static int local_to_utc_with(UtcOffsetFn offset_at, const void* zone, int64_t local, int64_t out[2]) {
+    int64_t guess = local - offset_at(zone, local);
+    int32_t before = offset_at(zone, guess - 86400);
+    int32_t offsets[3] = { before, offset_at(zone, guess), offset_at(zone, guess + 86400) };
+    int n = 0;
+    for (int k = 0; k < 3; k++) {
+        int64_t t = local - offsets[k];
+        if (offset_at(zone, t) != offsets[k]) continue;
+        if (n == 1 && out[0] == t) continue;
+        if (n == 2 && (out[0] == t || out[1] == t)) continue;
+        if (n < 2) out[n++] = t;
+    }
+    if (n == 2 && out[1] < out[0]) {
+        int64_t tmp = out[0];
+        out[0] = out[1];
+        out[1] = tmp;
+    }
+    if (n == 0) {
+        out[0] = local - before;
+        out[1] = local - offset_at(zone, out[0]);
+    }
+    return n;
+}
+
+static int32_t tzdata_offset_fn(const void* zone, int64_t t) {
+    return tzdata_lookup((const TzData*)zone, t).utoff;
+}
+
+static int tzdata_local_to_utc(const TzData* d, int64_t local, int64_t out[2]) {
+    return local_to_utc_with(tzdata_offset_fn, d, local, out);
+}
+
+/* Whether transition i changes the UTC offset (rather than only the
+ * abbreviation or DST flag). */
+static int tzdata_changes_offset(const TzData* d, uint32_t i) {
+    uint8_t prev = i == 0 ? 0 : d->idxs[i - 1];
+    return tzdata_type_info(d, d->idxs[i]).utoff != tzdata_type_info(d, prev).utoff;
+}
+
+/* Find the nearest offset change after t (forward != 0, the first change
+ * strictly after t) or at/before t (forward == 0). Returns 1 and sets *out
+ * if there is one in the transition table or the footer rule. */
+static int tzdata_offset_change(const TzData* d, int64_t t, int forward, int64_t* out) {
+    if (d->timecnt == 0) return d->rule ? posix_offset_change(d->rule, t, forward, out) : 0;
+    int64_t last = tzdata_time(d, d->timecnt - 1);
+    int64_t i = tzdata_find(d, t);
+    if (forward) {
+        for (int64_t k = i + 1; k < (int64_t)d->timecnt; k++) {
+            if (tzdata_changes_offset(d, (uint32_t)k)) { *out = tzdata_time(d, (uint32_t)k); return 1; }
+        }
+        /* Rule transitions only count after the table ends */
+        return d->rule && posix_offset_change(d->rule, t > last ? t : last, 1, out);
+    } else {
+        if (d->rule && t > last && posix_offset_change(d->rule, t, 0, out) && *out > last) return 1;
+        for (int64_t k = i; k >= 0; k--) {
+            if (tzdata_changes_offset(d, (uint32_t)k)) { *out = tzdata_time(d, (uint32_t)k); return 1; }
+        }
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Zone data sources
+ *
+ * Zones are served from the embedded snapshot when the library is built
+ * with CHRONOS_EMBED_TZDATA (lake build -K embedTzdata), otherwise from the
+ * system zoneinfo directory, whose files are memory-mapped and parsed in
+ * place. Setting CHRONOS_TZDATA=system or calling
+ * chronos_tzdata_set_prefer_system prefers the system database when both
+ * are available.
+ * ============================================================================ */
+
+#define TZ_SOURCE_LIBC 0
+#define TZ_SOURCE_EMBEDDED 1
+#define TZ_SOURCE_ZONEINFO 2
+#define TZ_SOURCE_POSIX 3
+#define TZ_SOURCE_FIXED 4
+
+#ifdef CHRONOS_EMBED_TZDATA
+typedef struct {
+    const char* name;
+    const unsigned char* data;
+    unsigned int size;
+} ChronosTzdataEntry;
+
+/* Defined in the generated ffi/tzdata_snapshot.c, sorted by name */
+extern const ChronosTzdataEntry chronos_tzdata_entries[];
+extern const unsigned int chronos_tzdata_entry_count;
+
+static const ChronosTzdataEntry* embedded_find(const char* name) {
+    unsigned int lo = 0, hi = chronos_tzdata_entry_count;
+    while (lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        int c = strcmp(chronos_tzdata_entries[mid].name, name);
+        if (c == 0) return &chronos_tzdata_entries[mid];
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return NULL;
+}
+#endif
+
+/* -1 until first use, then 0/1 */
+static int g_tzdata_prefer_system = -1;
+
+static int tzdata_prefer_system(void) {
+    if (g_tzdata_prefer_system < 0) {
+        const char* v = getenv("CHRONOS_TZDATA");
+        g_tzdata_prefer_system = (v && strcmp(v, "system") == 0) ? 1 : 0;
+    }
+    return g_tzdata_prefer_system;
+}
+
+static const char* zoneinfo_dir(void) {
+    const char* dir = getenv("TZDIR");
+    return (dir && dir[0]) ? dir : "/usr/share/zoneinfo";
+}
+
+/* Reject names that could escape the zoneinfo directory. */
+static int zone_name_is_safe(const char* name) {
+    if (!name[0] || name[0] == '/' || strlen(name) > 255) return 0;
+    for (const char* p = name; *p; p++) {
+        if (p[0] == '.' && p[1] == '.' && (p == name || p[-1] == '/')) return 0;
+    }
+    return 1;
+}
+
+/* Map a TZif file read-only and parse it in place. NULL if the file is
+ * missing or not TZif. */
+static TzData* tzdata_map_file(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 44) {
+        close(fd);
+        return NULL;
+    }
+    size_t len = (size_t)st.st_size;
+    void* base = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+
+    TzData* d = (TzData*)calloc(1, sizeof(TzData));
+    if (!d || tzdata_parse((const uint8_t*)base, len, d) != 0) {
+        free(d);
+        munmap(base, len);
+        return NULL;
+    }
+    d->mapped = 1;
+    return d;
+}
+
+static TzData* tzdata_map_zone(const char* name) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", zoneinfo_dir(), name);
+    return tzdata_map_file(path);
+}
+
+#ifdef CHRONOS_EMBED_TZDATA
+static TzData* tzdata_embedded(const char* name) {
+    const ChronosTzdataEntry* e = embedded_find(name);
+    if (!e) return NULL;
+    TzData* d = (TzData*)calloc(1, sizeof(TzData));
+    if (d && tzdata_parse(e->data, e->size, d) == 0) return d;
+    free(d);
+    return NULL;
+}
+#endif
+
+/* Load zone data for `name` from the preferred in-process source, or NULL
+ * when the zone should go through libc. Sets *source accordingly. */
+static TzData* tzdata_load(const char* name, int* source) {
+    *source = TZ_SOURCE_LIBC;
+    if (!zone_name_is_safe(name)) return NULL;
+    TzData* d = NULL;
+#ifdef CHRONOS_EMBED_TZDATA
+    if (!tzdata_prefer_system() && (d = tzdata_embedded(name))) {
+        *source = TZ_SOURCE_EMBEDDED;
+        return d;
+    }
+#endif
+    if ((d = tzdata_map_zone(name))) {
+        *source = TZ_SOURCE_ZONEINFO;
+        return d;
+    }
+#ifdef CHRONOS_EMBED_TZDATA
+    if ((d = tzdata_embedded(name))) {
+        *source = TZ_SOURCE_EMBEDDED;
+        return d;
+    }
+#endif
+    return NULL;
+}
+
+/* Zone data consisting of a POSIX rule alone. Takes ownership of `rule`. */
+static TzData* tzdata_from_rule(PosixTz* rule) {
+    if (!rule) return NULL;
+    TzData* d = (TzData*)calloc(1, sizeof(TzData));
+    if (!d) {
+        posix_free(rule);
+        return NULL;
+    }
+    d->rule = rule;
+    return d;
+}
+
+static void tzdata_free(TzData* d) {
+    if (!d) return;
+    if (d->mapped) munmap((void*)d->base, d->len);
+    posix_free(d->rule);
+    free(d);
+}
+
+/* ============================================================================
+ * chronos_tzdata_set_prefer_system : Bool -> IO Unit
+ * chronos_tzdata_embedded_names : IO (Array String)
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_tzdata_set_prefer_system(uint8_t prefer, lean_obj_arg world) {
+    g_tzdata_prefer_system = prefer ? 1 : 0;
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+LEAN_EXPORT lean_obj_res chronos_tzdata_embedded_names(lean_obj_arg world) {
+    lean_object* arr = lean_mk_empty_array();
+#ifdef CHRONOS_EMBED_TZDATA
+    for (unsigned int i = 0; i < chronos_tzdata_entry_count; i++) {
+        arr = lean_array_push(arr, lean_mk_string(chronos_tzdata_entries[i].name));
+    }
+#endif
+    return lean_io_result_mk_ok(arr);
+}
+
 /* ============================================================================
  * Timezone External Class
  *
@@ -305,6 +1056,8 @@ typedef struct {
 #endif
     char* name;             /* Canonical name for name() function */
     int is_utc;             /* 1 if this is UTC (special handling) */
+    TzData* data;           /* Parsed zone data, or NULL to go through libc */
+    int source;             /* TZ_SOURCE_* the zone was loaded from */
 } TimezoneWrapper;
 
 static lean_external_class* g_timezone_class = NULL;
@@ -322,6 +1075,7 @@ static void timezone_finalizer(void* ptr) {
         }
 #endif
         if (tz->name) free(tz->name);
+        tzdata_free(tz->data);
         free(tz);
     }
 }
@@ -348,13 +1102,27 @@ LEAN_EXPORT lean_obj_res chronos_timezone_from_name(b_lean_obj_arg name_obj, lea
     init_timezone_class();
     const char* name = lean_string_cstr(name_obj);
 
-    TimezoneWrapper* wrapper = (TimezoneWrapper*)malloc(sizeof(TimezoneWrapper));
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)calloc(1, sizeof(TimezoneWrapper));
     if (!wrapper) {
         return lean_io_result_mk_ok(lean_box(0));  /* None */
     }
     wrapper->name = strdup(name);
     wrapper->is_utc = (strcmp(name, "UTC") == 0 || strcmp(name, "Etc/UTC") == 0);
 
+    if (!wrapper->is_utc) {
+        /* Serve the zone from in-process data when a source has it */
+        wrapper->data = tzdata_load(name, &wrapper->source);
+        if (wrapper->data) {
+#ifndef HAVE_LOCALTIME_RZ
+            wrapper->tz_name = strdup(name);
+#endif
+            lean_object* tz_obj = lean_alloc_external(g_timezone_class, wrapper);
+            lean_object* some_tz = lean_alloc_ctor(1, 1, 0);  /* Some */
+            lean_ctor_set(some_tz, 0, tz_obj);
+            return lean_io_result_mk_ok(some_tz);
+        }
+    }
+
 #ifdef HAVE_LOCALTIME_RZ
     /* Use tzalloc to load timezone - returns NULL if invalid */
     wrapper->handle = tzalloc(name);
@@ -414,7 +1182,7 @@ LEAN_EXPORT lean_obj_res chronos_timezone_from_name(b_lean_obj_arg name_obj, lea
 LEAN_EXPORT lean_obj_res chronos_timezone_utc(lean_obj_arg world) {
     init_timezone_class();
 
-    TimezoneWrapper* wrapper = (TimezoneWrapper*)malloc(sizeof(TimezoneWrapper));
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)calloc(1, sizeof(TimezoneWrapper));
     wrapper->name = strdup("UTC");
     wrapper->is_utc = 1;
 
@@ -428,6 +1196,68 @@ LEAN_EXPORT lean_obj_res chronos_timezone_utc(lean_obj_arg world) {
     return lean_io_result_mk_ok(obj);
 }
 
+/* ============================================================================
+ * chronos_timezone_from_posix : String -> IO (Option Timezone)
+ *
+ * A timezone defined by a POSIX TZ string (e.g., "EST5EDT,M3.2.0,M11.1.0").
+ * Returns None if the string does not parse.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_from_posix(b_lean_obj_arg spec_obj, lean_obj_arg world) {
+    init_timezone_class();
+    const char* spec = lean_string_cstr(spec_obj);
+
+    TzData* data = tzdata_from_rule(posix_parse(spec));
+    if (!data) return lean_io_result_mk_ok(lean_box(0));  /* None */
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)calloc(1, sizeof(TimezoneWrapper));
+    if (!wrapper) {
+        tzdata_free(data);
+        return lean_io_result_mk_ok(lean_box(0));  /* None */
+    }
+    wrapper->name = strdup(spec);
+    wrapper->data = data;
+    wrapper->source = TZ_SOURCE_POSIX;
+
+    lean_object* tz_obj = lean_alloc_external(g_timezone_class, wrapper);
+    lean_object* some_tz = lean_alloc_ctor(1, 1, 0);  /* Some */
+    lean_ctor_set(some_tz, 0, tz_obj);
+    return lean_io_result_mk_ok(some_tz);
+}
+
+/* ============================================================================
+ * chronos_timezone_fixed : Int32 -> IO (Option Timezone)
+ *
+ * A timezone at a constant offset (seconds east of UTC), named like
+ * "+05:30". Conversions are pure arithmetic. Returns None unless the
+ * offset is under 24 hours in magnitude.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_fixed(int32_t offset, lean_obj_arg world) {
+    init_timezone_class();
+    if (offset <= -86400 || offset >= 86400) return lean_io_result_mk_ok(lean_box(0));  /* None */
+
+    TzData* data = tzdata_from_rule(posix_fixed(offset));
+    if (!data) return lean_io_result_mk_ok(lean_box(0));  /* None */
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)calloc(1, sizeof(TimezoneWrapper));
+    if (!wrapper) {
+        tzdata_free(data);
+        return lean_io_result_mk_ok(lean_box(0));  /* None */
+    }
+    int32_t a = offset < 0 ? -offset : offset;
+    char name[16];
+    if (a % 60) snprintf(name, sizeof(name), "%c%02d:%02d:%02d", offset < 0 ? '-' : '+',
+                         a / 3600, a % 3600 / 60, a % 60);
+    else snprintf(name, sizeof(name), "%c%02d:%02d", offset < 0 ? '-' : '+', a / 3600, a % 3600 / 60);
+    wrapper->name = strdup(name);
+    wrapper->data = data;
+    wrapper->source = TZ_SOURCE_FIXED;
+
+    lean_object* tz_obj = lean_alloc_external(g_timezone_class, wrapper);
+    lean_object* some_tz = lean_alloc_ctor(1, 1, 0);  /* Some */
+    lean_ctor_set(some_tz, 0, tz_obj);
+    return lean_io_result_mk_ok(some_tz);
+}
+
 /* ============================================================================
  * chronos_timezone_local : IO Timezone
  *
@@ -437,7 +1267,7 @@ LEAN_EXPORT lean_obj_res chronos_timezone_utc(lean_obj_arg world) {
 LEAN_EXPORT lean_obj_res chronos_timezone_local(lean_obj_arg world) {
     init_timezone_class();
 
-    TimezoneWrapper* wrapper = (TimezoneWrapper*)malloc(sizeof(TimezoneWrapper));
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)calloc(1, sizeof(TimezoneWrapper));
     wrapper->is_utc = 0;
 
 #ifdef HAVE_LOCALTIME_RZ
@@ -457,6 +1287,27 @@ LEAN_EXPORT lean_obj_res chronos_timezone_local(lean_obj_arg world) {
     wrapper->name = strdup(local_tm.tm_zone ? local_tm.tm_zone : "Local");
 #endif
 
+    /* Map the local zone's data: /etc/localtime when TZ is unset, the zone
+     * file TZ names (":Area/City", "Area/City" or an absolute path), or a
+     * POSIX rule string given directly in TZ. */
+    const char* env_tz = getenv("TZ");
+    if (!env_tz) {
+        wrapper->data = tzdata_map_file("/etc/localtime");
+        if (wrapper->data) wrapper->source = TZ_SOURCE_ZONEINFO;
+    } else {
+        const char* zone = env_tz[0] == ':' ? env_tz + 1 : env_tz;
+        if (zone[0] == '/') {
+            wrapper->data = tzdata_map_file(zone);
+            if (wrapper->data) wrapper->source = TZ_SOURCE_ZONEINFO;
+        } else {
+            wrapper->data = tzdata_load(zone, &wrapper->source);
+            if (!wrapper->data && zone == env_tz) {
+                wrapper->data = tzdata_from_rule(posix_parse(env_tz));
+                if (wrapper->data) wrapper->source = TZ_SOURCE_POSIX;
+            }
+        }
+    }
+
     lean_object* obj = lean_alloc_external(g_timezone_class, wrapper);
     return lean_io_result_mk_ok(obj);
 }
@@ -491,6 +1342,20 @@ LEAN_EXPORT lean_obj_res chronos_timezone_to_datetime(
     time_t t = (time_t)seconds;
     struct tm result;
 
+    if (wrapper->data) {
+        /* Zone data: offset lookup plus civil-date arithmetic */
+        int64_t local = seconds + tzdata_lookup(wrapper->data, seconds).utoff;
+        int64_t days = floor_div(local, 86400);
+        int64_t sod = local - days * 86400;
+        int64_t y;
+        unsigned m, d;
+        civil_from_days(days, &y, &m, &d);
+        return lean_io_result_mk_ok(mk_datetime_tuple(
+            (int32_t)y, (uint8_t)m, (uint8_t)d,
+            (uint8_t)(sod / 3600), (uint8_t)(sod % 3600 / 60), (uint8_t)(sod % 60),
+            nanos));
+    }
+
     if (wrapper->is_utc) {
         /* UTC: use gmtime_r */
         if (gmtime_r(&t, &result) == NULL) {
@@ -565,6 +1430,16 @@ LEAN_EXPORT lean_obj_res chronos_timezone_from_datetime(
 ) {
     TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
 
+    if (wrapper->data) {
+        /* Zone data: repeated wall times take the earlier instant, skipped
+         * ones shift forward by the gap (as mktime does) */
+        int64_t local = days_from_civil(year, month, day) * 86400 +
+                        hour * 3600 + minute * 60 + second;
+        int64_t out[2];
+        tzdata_local_to_utc(wrapper->data, local, out);
+        return lean_io_result_mk_ok(mk_pair(lean_int64_to_int(out[0]), lean_box_uint32(nanosecond)));
+    }
+
     struct tm tm_input;
     memset(&tm_input, 0, sizeof(tm_input));
     tm_input.tm_year = year - 1900;
@@ -629,3 +1504,818 @@ LEAN_EXPORT lean_obj_res chronos_timezone_from_datetime(
 
     return lean_io_result_mk_ok(mk_pair(seconds, nanos));
 }
+
+/* ============================================================================
+ * Local wall-clock boundaries
+ *
+ * These resolve many local wall times in one call, switching TZ once
+ * instead of once per conversion.
+ * ============================================================================ */
+
+/* Point TZ at the wrapper's zone. Returns the previous TZ value (or NULL),
+ * which must be passed to tz_swap_out. With localtime_rz the handle is
+ * used directly and TZ is left alone. */
+static char* tz_swap_in(TimezoneWrapper* wrapper) {
+#ifdef HAVE_LOCALTIME_RZ
+    (void)wrapper;
+    return NULL;
+#else
+    char* old_tz = getenv("TZ");
+    char* saved_tz = old_tz ? strdup(old_tz) : NULL;
+    if (wrapper->is_utc) {
+        setenv("TZ", "UTC0", 1);
+    } else if (wrapper->tz_name) {
+        char tz_val[512];
+        snprintf(tz_val, sizeof(tz_val), ":%s", wrapper->tz_name);
+        setenv("TZ", tz_val, 1);
+    } else {
+        unsetenv("TZ");
+    }
+    tzset();
+    return saved_tz;
+#endif
+}
+
+static void tz_swap_out(char* saved_tz) {
+#ifndef HAVE_LOCALTIME_RZ
+    if (saved_tz) {
+        setenv("TZ", saved_tz, 1);
+        free(saved_tz);
+    } else {
+        unsetenv("TZ");
+    }
+    tzset();
+#else
+    (void)saved_tz;
+#endif
+}
+
+/* mktime/localtime_r in the wrapper's zone; TZ must be swapped in. */
+static time_t tz_mktime(TimezoneWrapper* wrapper, struct tm* tm_input) {
+#ifdef HAVE_LOCALTIME_RZ
+    if (wrapper->is_utc) return timegm(tm_input);
+    return mktime_z(wrapper->handle, tm_input);
+#else
+    (void)wrapper;
+    return mktime(tm_input);
+#endif
+}
+
+static struct tm* tz_localtime(TimezoneWrapper* wrapper, const time_t* t, struct tm* result) {
+#ifdef HAVE_LOCALTIME_RZ
+    if (wrapper->is_utc) return gmtime_r(t, result);
+    return localtime_rz(wrapper->handle, t, result);
+#else
+    (void)wrapper;
+    return localtime_r(t, result);
+#endif
+}
+
+/* Resolve local wall time `date hour:00:00` with the given tm_isdst hint.
+ * Returns 1 when the result reads back as exactly that wall time, i.e. the
+ * wall time exists with that DST flag. */
+static int resolve_wall_hour(TimezoneWrapper* wrapper, const struct tm* date,
+                             int hour, int isdst, time_t* out) {
+    struct tm tm_input = *date;
+    tm_input.tm_hour = hour;
+    tm_input.tm_min = 0;
+    tm_input.tm_sec = 0;
+    tm_input.tm_isdst = isdst;
+
+    errno = 0;
+    time_t t = tz_mktime(wrapper, &tm_input);
+    if (t == (time_t)-1 && errno != 0) return 0;
+    *out = t;
+
+    struct tm back;
+    if (tz_localtime(wrapper, &t, &back) == NULL) return 0;
+    return back.tm_year == date->tm_year && back.tm_mon == date->tm_mon &&
+           back.tm_mday == date->tm_mday && back.tm_hour == hour &&
+           back.tm_min == 0 && back.tm_sec == 0;
+}
+
+/* Wall boundaries from zone data, with the same semantics as the libc
+ * path below. */
+static lean_object* tzdata_wall_boundaries(const TzData* d, int64_t first_day,
+                                           uint32_t days, uint8_t step_hours) {
+    lean_object* arr = lean_mk_empty_array();
+    int64_t last = INT64_MIN;
+    for (uint32_t i = 0; i <= days; i++) {
+        int64_t day = first_day + (int64_t)i;
+        int hour_limit = (step_hours >= 24 || i == days) ? 1 : 24;
+        for (int h = 0; h < hour_limit; h += step_hours) {
+            int64_t out[2];
+            int n = tzdata_local_to_utc(d, day * 86400 + h * 3600, out);
+            /* Skipped hours are dropped, except a skipped midnight, where
+             * the day starts just after the gap */
+            if (n == 0 && h != 0) continue;
+            /* Day starts take only the first of a repeated midnight */
+            int count = (n == 2 && hour_limit > 1) ? 2 : 1;
+            for (int k = 0; k < count; k++) {
+                if (out[k] > last) {
+                    arr = lean_array_push(arr, lean_int64_to_int(out[k]));
+                    last = out[k];
+                }
+            }
+        }
+    }
+    return arr;
+}
+
+/* ============================================================================
+ * chronos_timezone_wall_boundaries : Timezone -> Int -> UInt32 -> UInt8 -> IO (Array Int)
+ *
+ * UTC seconds of local wall-clock boundaries for `days` local days starting
+ * at epoch day `first_day`, in ascending order.
+ *
+ * step_hours >= 24: one boundary per day (its first instant) plus the start
+ *   of the day after the range, so days + 1 values.
+ * step_hours < 24: every occurrence of each hour h = 0, step, 2*step, ...;
+ *   repeated hours after a DST fall-back appear twice, hours skipped by a
+ *   spring-forward are omitted. The start of the following day is appended.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_wall_boundaries(
+    b_lean_obj_arg tz_obj,
+    lean_obj_arg first_day_obj,
+    uint32_t days,
+    uint8_t step_hours,
+    lean_obj_arg world
+) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    int64_t first_day = lean_int64_of_int(first_day_obj);
+    lean_dec(first_day_obj);
+    if (step_hours == 0) step_hours = 1;
+    if (wrapper->data) {
+        return lean_io_result_mk_ok(tzdata_wall_boundaries(wrapper->data, first_day, days, step_hours));
+    }
+
+    lean_object* arr = lean_mk_empty_array();
+    char* saved_tz = tz_swap_in(wrapper);
+
+    int64_t last = INT64_MIN;
+    for (uint32_t i = 0; i <= days; i++) {
+        /* Civil date of the epoch day, via gmtime on its UTC midnight */
+        time_t utc_midnight = (time_t)((first_day + (int64_t)i) * 86400);
+        struct tm date;
+        if (gmtime_r(&utc_midnight, &date) == NULL) {
+            tz_swap_out(saved_tz);
+            lean_dec(arr);
+            return mk_io_error("gmtime_r failed");
+        }
+
+        int hour_limit = (step_hours >= 24 || i == days) ? 1 : 24;
+        for (int h = 0; h < hour_limit; h += step_hours) {
+            time_t std_t = 0, dst_t = 0, t;
+            int std_ok = resolve_wall_hour(wrapper, &date, h, 0, &std_t);
+            int dst_ok = resolve_wall_hour(wrapper, &date, h, 1, &dst_t);
+
+            if (std_ok && dst_ok && std_t != dst_t) {
+                /* Repeated wall hour: both occurrences, earlier first */
+                time_t a = std_t < dst_t ? std_t : dst_t;
+                time_t b = std_t < dst_t ? dst_t : std_t;
+                if (hour_limit == 1) {
+                    /* Day start: only the first instant of the day */
+                    if ((int64_t)a > last) { arr = lean_array_push(arr, lean_int64_to_int(a)); last = a; }
+                    continue;
+                }
+                if ((int64_t)a > last) { arr = lean_array_push(arr, lean_int64_to_int(a)); last = a; }
+                if ((int64_t)b > last) { arr = lean_array_push(arr, lean_int64_to_int(b)); last = b; }
+                continue;
+            }
+            if (std_ok || dst_ok) {
+                t = std_ok ? std_t : dst_t;
+            } else if (h == 0) {
+                /* Midnight skipped by a transition: the day starts at the
+                 * normalized instant just after the gap */
+                struct tm tm_input = date;
+                tm_input.tm_isdst = -1;
+                errno = 0;
+                t = tz_mktime(wrapper, &tm_input);
+                if (t == (time_t)-1 && errno != 0) continue;
+            } else {
+                continue;
+            }
+            if ((int64_t)t > last) {
+                arr = lean_array_push(arr, lean_int64_to_int(t));
+                last = t;
+            }
+        }
+    }
+
+    tz_swap_out(saved_tz);
+    return lean_io_result_mk_ok(arr);
+}
+
+/* ============================================================================
+ * Many zones per call
+ *
+ * World-clock style conversions: one or a few instants against many zones
+ * in one FFI crossing. Zones with in-process data need no TZ switch; each
+ * libc-backed zone is switched in once for all of the instants.
+ * ============================================================================ */
+
+/* UTC offset at t for a libc-backed zone; TZ must be swapped in. */
+static int64_t tz_libc_offset(TimezoneWrapper* wrapper, int64_t seconds) {
+    if (wrapper->is_utc) return 0;
+    time_t t = (time_t)seconds;
+    struct tm result;
+    return tz_localtime(wrapper, &t, &result) ? (int64_t)result.tm_gmtoff : 0;
+}
+
+/* ============================================================================
+ * chronos_timezones_offsets_at : Array Timezone -> Array Int -> IO (Array Int)
+ *
+ * UTC offsets (seconds east) of every zone at every instant, zone-major:
+ * element z * n + i is zone z at instant i.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezones_offsets_at(b_lean_obj_arg zones, b_lean_obj_arg seconds,
+                                                      lean_obj_arg world) {
+    size_t nz = lean_array_size(zones), n = lean_array_size(seconds);
+    lean_object* arr = lean_alloc_array(0, nz * n);
+    for (size_t z = 0; z < nz; z++) {
+        TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(lean_array_get_core(zones, z));
+        char* saved_tz = (wrapper->data || wrapper->is_utc) ? NULL : tz_swap_in(wrapper);
+        for (size_t i = 0; i < n; i++) {
+            int64_t t = lean_int64_of_int(lean_array_get_core(seconds, i));
+            int64_t off = wrapper->data ? tzdata_lookup(wrapper->data, t).utoff : tz_libc_offset(wrapper, t);
+            arr = lean_array_push(arr, lean_int64_to_int(off));
+        }
+        if (!wrapper->data && !wrapper->is_utc) tz_swap_out(saved_tz);
+    }
+    return lean_io_result_mk_ok(arr);
+}
+
+/* ============================================================================
+ * chronos_timezones_from_local : Array Timezone -> Int -> IO (Array Int)
+ *
+ * UTC seconds at which each zone's wall clock reads `local` (seconds since
+ * 1970-01-01 in local time). Repeated wall times take the earlier instant
+ * and skipped ones shift forward by the gap, as in
+ * chronos_timezone_from_datetime.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezones_from_local(b_lean_obj_arg zones, b_lean_obj_arg local_obj,
+                                                      lean_obj_arg world) {
+    int64_t local = lean_int64_of_int(local_obj);
+    size_t nz = lean_array_size(zones);
+    lean_object* arr = lean_alloc_array(0, nz);
+
+    int64_t days = floor_div(local, 86400);
+    int64_t sod = local - days * 86400;
+    int64_t y;
+    unsigned m, d;
+    civil_from_days(days, &y, &m, &d);
+
+    for (size_t z = 0; z < nz; z++) {
+        TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(lean_array_get_core(zones, z));
+        int64_t t;
+        if (wrapper->data) {
+            int64_t out[2];
+            tzdata_local_to_utc(wrapper->data, local, out);
+            t = out[0];
+        } else if (wrapper->is_utc) {
+            t = local;
+        } else {
+            struct tm tm_input;
+            memset(&tm_input, 0, sizeof(tm_input));
+            tm_input.tm_year = (int)(y - 1900);
+            tm_input.tm_mon = (int)m - 1;
+            tm_input.tm_mday = (int)d;
+            tm_input.tm_hour = (int)(sod / 3600);
+            tm_input.tm_min = (int)(sod % 3600 / 60);
+            tm_input.tm_sec = (int)(sod % 60);
+            tm_input.tm_isdst = -1;
+            char* saved_tz = tz_swap_in(wrapper);
+            t = (int64_t)tz_mktime(wrapper, &tm_input);
+            tz_swap_out(saved_tz);
+        }
+        arr = lean_array_push(arr, lean_int64_to_int(t));
+    }
+    return lean_io_result_mk_ok(arr);
+}
+
+/* ============================================================================
+ * chronos_timezone_local_candidates : Timezone -> Array Int -> IO (Array Int)
+ *
+ * Classify local wall times (seconds since 1970-01-01 local) against the
+ * zone's transitions. For each input, three values: the number of
+ * instants that read as that wall time (0, 1 or 2) and two UTC seconds.
+ *   1: the instant, twice
+ *   2: the earlier and later instants of a repeated wall time
+ *   0: the wall time shifted forward by the gap (offset before it), then
+ *      shifted backward (offset after it)
+ * Zone data answers with offset lookups only; libc-backed zones use the
+ * same search over localtime offsets with TZ switched in once.
+ * ============================================================================ */
+
+static int32_t libc_offset_fn(const void* zone, int64_t t) {
+    return (int32_t)tz_libc_offset((TimezoneWrapper*)zone, t);
+}
+
+LEAN_EXPORT lean_obj_res chronos_timezone_local_candidates(b_lean_obj_arg tz_obj, b_lean_obj_arg locals,
+                                                           lean_obj_arg world) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    size_t n = lean_array_size(locals);
+    lean_object* arr = lean_alloc_array(0, 3 * n);
+    int use_libc = !wrapper->data && !wrapper->is_utc;
+    char* saved_tz = use_libc ? tz_swap_in(wrapper) : NULL;
+    for (size_t i = 0; i < n; i++) {
+        int64_t local = lean_int64_of_int(lean_array_get_core(locals, i));
+        int64_t out[2] = { local, local };
+        int count = 1;
+        if (wrapper->data) {
+            count = tzdata_local_to_utc(wrapper->data, local, out);
+        } else if (use_libc) {
+            count = local_to_utc_with(libc_offset_fn, wrapper, local, out);
+        }
+        if (count == 1) out[1] = out[0];
+        arr = lean_array_push(arr, lean_box((size_t)count));
+        arr = lean_array_push(arr, lean_int64_to_int(out[0]));
+        arr = lean_array_push(arr, lean_int64_to_int(out[1]));
+    }
+    if (use_libc) tz_swap_out(saved_tz);
+    return lean_io_result_mk_ok(arr);
+}
+
+/* ============================================================================
+ * chronos_timezone_source : Timezone -> IO UInt8
+ *
+ * Where the zone's rules come from (TZ_SOURCE_*).
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_source(b_lean_obj_arg tz_obj, lean_obj_arg world) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    return lean_io_result_mk_ok(lean_box((size_t)wrapper->source));
+}
+
+/* ============================================================================
+ * chronos_timezone_offset_at : Timezone -> Int -> Option Int
+ *
+ * UTC offset in seconds (local - UTC) at a UTC instant, from in-process
+ * zone data. None for zones resolved through libc, which would need TZ
+ * switched; chronos_timezone_libc_offset_at answers those in IO.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_offset_at(b_lean_obj_arg tz_obj, b_lean_obj_arg seconds_obj) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    int64_t offset;
+    if (wrapper->data) {
+        offset = tzdata_lookup(wrapper->data, lean_int64_of_int(seconds_obj)).utoff;
+    } else if (wrapper->is_utc) {
+        offset = 0;
+    } else {
+        return lean_box(0);  /* None */
+    }
+    lean_object* some = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(some, 0, lean_int64_to_int(offset));
+    return some;
+}
+
+/* ============================================================================
+ * chronos_timezone_libc_offset_at : Timezone -> Int -> IO Int
+ *
+ * UTC offset in seconds at a UTC instant through libc, for zones without
+ * in-process data.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_libc_offset_at(b_lean_obj_arg tz_obj, b_lean_obj_arg seconds_obj,
+                                                         lean_obj_arg world) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    if (wrapper->is_utc) return lean_io_result_mk_ok(lean_int64_to_int(0));
+
+    char* saved_tz = tz_swap_in(wrapper);
+    time_t t = (time_t)lean_int64_of_int(seconds_obj);
+    struct tm result;
+    struct tm* ok = tz_localtime(wrapper, &t, &result);
+    tz_swap_out(saved_tz);
+    if (!ok) return mk_io_error("localtime_r failed");
+    return lean_io_result_mk_ok(lean_int64_to_int((int64_t)result.tm_gmtoff));
+}
+
+/* ============================================================================
+ * chronos_timezone_probe_change : Timezone -> Int -> UInt32 -> IO (Option Int)
+ *
+ * The first instant in (seconds, seconds + horizon] at which the UTC
+ * offset changes. Zone data is searched directly; libc zones are probed
+ * hour by hour with TZ switched once, and the first change is bisected
+ * to the second.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_probe_change(b_lean_obj_arg tz_obj, b_lean_obj_arg seconds_obj,
+                                                       uint32_t horizon, lean_obj_arg world) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    int64_t start = lean_int64_of_int(seconds_obj);
+    int64_t limit = start + (int64_t)horizon;
+    int64_t out;
+    int found = 0;
+
+    if (wrapper->data) {
+        found = tzdata_offset_change(wrapper->data, start, 1, &out) && out <= limit;
+    } else if (!wrapper->is_utc) {
+        char* saved_tz = tz_swap_in(wrapper);
+        int64_t base = tz_libc_offset(wrapper, start);
+        int64_t lo = start;
+        while (lo < limit) {
+            int64_t hi = lo + 3600 < limit ? lo + 3600 : limit;
+            if (tz_libc_offset(wrapper, hi) != base) {
+                /* Offset at lo is base, at hi it differs */
+                while (hi - lo > 1) {
+                    int64_t mid = lo + (hi - lo) / 2;
+                    if (tz_libc_offset(wrapper, mid) == base) lo = mid; else hi = mid;
+                }
+                out = hi;
+                found = 1;
+                break;
+            }
+            lo = hi;
+        }
+        tz_swap_out(saved_tz);
+    }
+
+    if (!found) return lean_io_result_mk_ok(lean_box(0));  /* None */
+    lean_object* some = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(some, 0, lean_int64_to_int(out));
+    return lean_io_result_mk_ok(some);
+}
+
+/* ============================================================================
+ * chronos_timezone_offset_change : Timezone -> Int -> Bool -> Option Int
+ *
+ * The first instant after `seconds` at which the UTC offset changes
+ * (forward), or the start of the offset period containing `seconds`
+ * (backward). None when unknown: no change in the zone data, or a zone
+ * resolved through libc.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_offset_change(b_lean_obj_arg tz_obj, b_lean_obj_arg seconds_obj,
+                                                        uint8_t forward) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    int64_t out;
+    if (!wrapper->data ||
+        !tzdata_offset_change(wrapper->data, lean_int64_of_int(seconds_obj), forward, &out)) {
+        return lean_box(0);  /* None */
+    }
+    lean_object* some = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(some, 0, lean_int64_to_int(out));
+    return some;
+}
+
+/* ============================================================================
+ * chronos_timezone_posix_rule : Timezone -> Option String
+ *
+ * The POSIX TZ string governing the zone after its last transition (the
+ * TZif footer), or the whole zone for one built from a rule.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_posix_rule(b_lean_obj_arg tz_obj) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    if (!wrapper->data || !wrapper->data->rule) return lean_box(0);  /* None */
+    lean_object* some = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(some, 0, lean_mk_string(wrapper->data->rule->spec));
+    return some;
+}
+
+/* ============================================================================
+ * chronos_timezone_rule_transitions : Timezone -> Int -> Option (Int x Int)
+ *
+ * UTC instants at which the zone's POSIX rule starts and ends DST in the
+ * given year. None if the zone has no rule or the rule has no DST.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_timezone_rule_transitions(b_lean_obj_arg tz_obj, b_lean_obj_arg year_obj) {
+    TimezoneWrapper* wrapper = (TimezoneWrapper*)lean_get_external_data(tz_obj);
+    if (!wrapper->data || !wrapper->data->rule || !wrapper->data->rule->has_dst) return lean_box(0);
+    int64_t start, end;
+    posix_year(wrapper->data->rule, lean_int64_of_int(year_obj), &start, &end);
+    lean_object* some = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(some, 0, mk_pair(lean_int64_to_int(start), lean_int64_to_int(end)));
+    return some;
+}
+
+/* ============================================================================
+ * Time-indexed segment files
+ *
+ * Layout (all integers little-endian):
+ *   header, 64 bytes: "CHRSEG01", u32 version, u32 block_size, zero padding
+ *   blocks of exactly block_size bytes:
+ *     u32 magic "CSBK", u32 count, i64 first_ns, i64 last_ns,
+ *     u32 payload_bytes, u32 reserved
+ *     count records of 16 bytes: i64 ns, u32 payload offset (from the block
+ *     start), u32 payload length
+ *     payload bytes, then zero padding
+ *
+ * Blocks sit at fixed offsets, so their headers act as a sparse index that
+ * is binary-searched in place; nothing is parsed at open. Timestamps are
+ * nanoseconds since the Unix epoch, non-decreasing across the file.
+ * ============================================================================ */
+
+#define SEGMENT_HEADER_SIZE 64
+#define SEGMENT_BLOCK_HEADER_SIZE 32
+#define SEGMENT_RECORD_SIZE 16
+#define SEGMENT_BLOCK_MAGIC 0x4B424353u  /* "CSBK" */
+
+typedef struct {
+    const uint8_t* base;
+    size_t len;
+    uint32_t block_size;
+    uint64_t blocks;            /* Complete, valid blocks */
+} Segment;
+
+static lean_external_class* g_segment_class = NULL;
+
+static void segment_finalizer(void* ptr) {
+    Segment* seg = (Segment*)ptr;
+    if (seg) {
+        if (seg->base) munmap((void*)seg->base, seg->len);
+        free(seg);
+    }
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int64_t le64(const uint8_t* p) {
+    return (int64_t)((uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32));
+}
+
+static const uint8_t* segment_block(const Segment* seg, uint64_t b) {
+    return seg->base + SEGMENT_HEADER_SIZE + b * seg->block_size;
+}
+
+static uint32_t segment_block_count(const Segment* seg, uint64_t b) {
+    return le32(segment_block(seg, b) + 4);
+}
+
+static int64_t segment_record_ns(const Segment* seg, uint64_t b, uint32_t r) {
+    return le64(segment_block(seg, b) + SEGMENT_BLOCK_HEADER_SIZE + (size_t)r * SEGMENT_RECORD_SIZE);
+}
+
+/* A block is usable if its magic is right and its records fit. */
+static int segment_block_valid(const Segment* seg, uint64_t b) {
+    const uint8_t* blk = segment_block(seg, b);
+    uint32_t count = le32(blk + 4);
+    return le32(blk) == SEGMENT_BLOCK_MAGIC && count > 0 &&
+           (uint64_t)count * SEGMENT_RECORD_SIZE <= seg->block_size - SEGMENT_BLOCK_HEADER_SIZE;
+}
+
+/* ============================================================================
+ * chronos_segment_open : String -> IO Segment
+ *
+ * Map a segment file read-only. Blocks written after the call are not
+ * visible; reopen to see them.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_segment_open(b_lean_obj_arg path_obj, lean_obj_arg world) {
+    if (g_segment_class == NULL) {
+        g_segment_class = lean_register_external_class(segment_finalizer, noop_foreach);
+    }
+    const char* path = lean_string_cstr(path_obj);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return mk_io_error("segment: cannot open file");
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < SEGMENT_HEADER_SIZE) {
+        close(fd);
+        return mk_io_error("segment: file too short");
+    }
+    size_t len = (size_t)st.st_size;
+    void* base = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return mk_io_error("segment: mmap failed");
+
+    const uint8_t* p = (const uint8_t*)base;
+    uint32_t block_size = le32(p + 12);
+    if (memcmp(p, "CHRSEG01", 8) != 0 || le32(p + 8) != 1 ||
+        block_size < SEGMENT_BLOCK_HEADER_SIZE + SEGMENT_RECORD_SIZE) {
+        munmap(base, len);
+        return mk_io_error("segment: bad header");
+    }
+
+    Segment* seg = (Segment*)calloc(1, sizeof(Segment));
+    if (!seg) {
+        munmap(base, len);
+        return mk_io_error("segment: out of memory");
+    }
+    seg->base = p;
+    seg->len = len;
+    seg->block_size = block_size;
+    /* A torn or corrupt block ends the readable part of the file */
+    uint64_t blocks = (len - SEGMENT_HEADER_SIZE) / block_size;
+    seg->blocks = 0;
+    while (seg->blocks < blocks && segment_block_valid(seg, seg->blocks)) seg->blocks++;
+    return lean_io_result_mk_ok(lean_alloc_external(g_segment_class, seg));
+}
+
+/* ============================================================================
+ * chronos_segment_info : Segment -> IO (UInt32 × UInt64)
+ *
+ * Block size and number of readable blocks.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_segment_info(b_lean_obj_arg seg_obj, lean_obj_arg world) {
+    Segment* seg = (Segment*)lean_get_external_data(seg_obj);
+    return lean_io_result_mk_ok(mk_pair(lean_box_uint32(seg->block_size), lean_box_uint64(seg->blocks)));
+}
+
+/* ============================================================================
+ * chronos_segment_bounds : Segment -> IO (Option (Int × Int))
+ *
+ * First and last record timestamps (nanoseconds), None if empty.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_segment_bounds(b_lean_obj_arg seg_obj, lean_obj_arg world) {
+    Segment* seg = (Segment*)lean_get_external_data(seg_obj);
+    if (seg->blocks == 0) return lean_io_result_mk_ok(lean_box(0));
+    int64_t first = le64(segment_block(seg, 0) + 8);
+    int64_t last = le64(segment_block(seg, seg->blocks - 1) + 16);
+    lean_object* some = lean_alloc_ctor(1, 1, 0);
+    lean_ctor_set(some, 0, mk_pair(lean_int64_to_int(first), lean_int64_to_int(last)));
+    return lean_io_result_mk_ok(some);
+}
+
+/* ============================================================================
+ * chronos_segment_seek : Segment -> Int -> IO (UInt64 × UInt32)
+ *
+ * Position (block, record) of the first record with ns >= target, or
+ * (blocks, 0) if there is none. Binary search over block headers, then
+ * over the block's records.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_segment_seek(b_lean_obj_arg seg_obj, b_lean_obj_arg ns_obj, lean_obj_arg world) {
+    Segment* seg = (Segment*)lean_get_external_data(seg_obj);
+    int64_t target = lean_int64_of_int(ns_obj);
+
+    /* First block whose last record is >= target */
+    uint64_t lo = 0, hi = seg->blocks;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (le64(segment_block(seg, mid) + 16) < target) lo = mid + 1; else hi = mid;
+    }
+    uint32_t rec = 0;
+    if (lo < seg->blocks) {
+        uint32_t rlo = 0, rhi = segment_block_count(seg, lo);
+        while (rlo < rhi) {
+            uint32_t mid = rlo + (rhi - rlo) / 2;
+            if (segment_record_ns(seg, lo, mid) < target) rlo = mid + 1; else rhi = mid;
+        }
+        rec = rlo;
+    }
+    return lean_io_result_mk_ok(mk_pair(lean_box_uint64(lo), lean_box_uint32(rec)));
+}
+
+/* ============================================================================
+ * chronos_segment_read : Segment -> UInt64 -> UInt32 -> UInt32 -> Int
+ *                        -> IO (Array (Int × ByteArray) × (UInt64 × UInt32))
+ *
+ * Up to `max` records from position (block, record), stopping before the
+ * first record with ns >= stop. Returns the records and the position after
+ * the last one read.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_segment_read(b_lean_obj_arg seg_obj, uint64_t block, uint32_t record,
+                                              uint32_t max, b_lean_obj_arg stop_obj, lean_obj_arg world) {
+    Segment* seg = (Segment*)lean_get_external_data(seg_obj);
+    int64_t stop = lean_int64_of_int(stop_obj);
+    lean_object* arr = lean_mk_empty_array();
+    uint32_t n = 0;
+
+    while (block < seg->blocks && n < max) {
+        const uint8_t* blk = segment_block(seg, block);
+        uint32_t count = le32(blk + 4);
+        if (record >= count) {
+            block++;
+            record = 0;
+            continue;
+        }
+        const uint8_t* rec = blk + SEGMENT_BLOCK_HEADER_SIZE + (size_t)record * SEGMENT_RECORD_SIZE;
+        int64_t ns = le64(rec);
+        if (ns >= stop) break;
+        uint32_t off = le32(rec + 8), len = le32(rec + 12);
+        if ((uint64_t)off + len > seg->block_size) {
+            lean_dec(arr);
+            return mk_io_error("segment: corrupt record");
+        }
+        lean_object* payload = lean_alloc_sarray(1, len, len);
+        memcpy(lean_sarray_cptr(payload), blk + off, len);
+        arr = lean_array_push(arr, mk_pair(lean_int64_to_int(ns), payload));
+        record++;
+        n++;
+    }
+    if (block < seg->blocks && record >= segment_block_count(seg, block)) {
+        block++;
+        record = 0;
+    }
+    lean_object* pos = mk_pair(lean_box_uint64(block), lean_box_uint32(record));
+    return lean_io_result_mk_ok(mk_pair(arr, pos));
+}
+
+/* ============================================================================
+ * chronos_segment_truncate : String -> UInt64 -> IO Unit
+ *
+ * Cut a segment file to `size` bytes, dropping a torn trailing block so
+ * later appends land on block boundaries.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_segment_truncate(b_lean_obj_arg path_obj, uint64_t size, lean_obj_arg world) {
+    if (truncate(lean_string_cstr(path_obj), (off_t)size) != 0) {
+        return mk_io_error("segment: truncate failed");
+    }
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+/* ============================================================================
+ * Read-only mapped files
+ *
+ * Random access to large files without reading them whole, for searching
+ * sorted text logs by position.
+ * ============================================================================ */
+
+typedef struct {
+    const uint8_t* base;        /* NULL for an empty file */
+    size_t len;
+} MappedFile;
+
+static lean_external_class* g_mapped_file_class = NULL;
+
+static void mapped_file_finalizer(void* ptr) {
+    MappedFile* mf = (MappedFile*)ptr;
+    if (mf) {
+        if (mf->base) munmap((void*)mf->base, mf->len);
+        free(mf);
+    }
+}
+
+/* ============================================================================
+ * chronos_mapped_file_open : String -> IO MappedFile
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_mapped_file_open(b_lean_obj_arg path_obj, lean_obj_arg world) {
+    if (g_mapped_file_class == NULL) {
+        g_mapped_file_class = lean_register_external_class(mapped_file_finalizer, noop_foreach);
+    }
+    int fd = open(lean_string_cstr(path_obj), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return mk_io_error("cannot open file");
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return mk_io_error("not a regular file");
+    }
+    MappedFile* mf = (MappedFile*)calloc(1, sizeof(MappedFile));
+    if (!mf) {
+        close(fd);
+        return mk_io_error("out of memory");
+    }
+    if (st.st_size > 0) {
+        void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            free(mf);
+            return mk_io_error("mmap failed");
+        }
+        madvise(base, (size_t)st.st_size, MADV_RANDOM);
+        mf->base = (const uint8_t*)base;
+        mf->len = (size_t)st.st_size;
+    }
+    close(fd);
+    return lean_io_result_mk_ok(lean_alloc_external(g_mapped_file_class, mf));
+}
+
+/* ============================================================================
+ * chronos_mapped_file_size : MappedFile -> UInt64
+ * ============================================================================ */
+
+LEAN_EXPORT uint64_t chronos_mapped_file_size(b_lean_obj_arg mf_obj) {
+    return ((MappedFile*)lean_get_external_data(mf_obj))->len;
+}
+
+/* ============================================================================
+ * chronos_mapped_file_read : MappedFile -> UInt64 -> UInt64 -> IO ByteArray
+ *
+ * Bytes [off, off + len), clamped to the end of the file.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_mapped_file_read(b_lean_obj_arg mf_obj, uint64_t off, uint64_t len,
+                                                  lean_obj_arg world) {
+    MappedFile* mf = (MappedFile*)lean_get_external_data(mf_obj);
+    if (off > mf->len) off = mf->len;
+    if (len > mf->len - off) len = mf->len - off;
+    lean_object* bytes = lean_alloc_sarray(1, len, len);
+    if (len) memcpy(lean_sarray_cptr(bytes), mf->base + off, len);
+    return lean_io_result_mk_ok(bytes);
+}
+
+/* ============================================================================
+ * chronos_mapped_file_find_byte : MappedFile -> UInt64 -> UInt8 -> IO UInt64
+ *
+ * Offset of the first `byte` at or after `off`, or the file size.
+ * ============================================================================ */
+
+LEAN_EXPORT lean_obj_res chronos_mapped_file_find_byte(b_lean_obj_arg mf_obj, uint64_t off, uint8_t byte,
+                                                       lean_obj_arg world) {
+    MappedFile* mf = (MappedFile*)lean_get_external_data(mf_obj);
+    if (off >= mf->len) return lean_io_result_mk_ok(lean_box_uint64(mf->len));
+    const uint8_t* p = memchr(mf->base + off, byte, mf->len - off);
+    return lean_io_result_mk_ok(lean_box_uint64(p ? (uint64_t)(p - mf->base) : mf->len));
+}
@@ -20,15 +20,90 @@ lean_exe chronos_tests where
 lean_exe chronos_demo where
   root := `Main
 
+lean_exe chronos_bench where
+  root := `Bench.Main
+
+/-- `lake build -K embedTzdata` links a tzdata snapshot into `chronos_native`
+    (generate it first with `lake script run gen_tzdata`). -/
+def embedTzdata : Bool := (get_config? embedTzdata).isSome
+
 -- FFI: Build C code
 target chronos_ffi_o pkg : FilePath := do
   let oFile := pkg.buildDir / "ffi" / "chronos_ffi.o"
   let srcJob ← inputTextFile <| pkg.dir / "ffi" / "chronos_ffi.c"
   let leanIncludeDir ← getLeanIncludeDir
   let weakArgs := #["-I", leanIncludeDir.toString]
-  buildO oFile srcJob weakArgs #["-fPIC", "-O2"] "cc" getLeanTrace
+  let defines := if embedTzdata then #["-DCHRONOS_EMBED_TZDATA"] else #[]
+  buildO oFile srcJob weakArgs (#["-fPIC", "-O2"] ++ defines) "cc" getLeanTrace
+
+target chronos_tzdata_o pkg : FilePath := do
+  let oFile := pkg.buildDir / "ffi" / "tzdata_snapshot.o"
+  let srcJob ← inputTextFile <| pkg.dir / "ffi" / "tzdata_snapshot.c"
+  buildO oFile srcJob #[] #["-fPIC", "-O2"] "cc" getLeanTrace
 
 extern_lib chronos_native pkg := do
   let name := nameToStaticLib "chronos_native"
-  let ffiO ← chronos_ffi_o.fetch
-  buildStaticLib (pkg.buildDir / "lib" / name) #[ffiO]
+  let mut objs := #[← chronos_ffi_o.fetch]
+  if embedTzdata then
+    objs := objs.push (← chronos_tzdata_o.fetch)
+  buildStaticLib (pkg.buildDir / "lib" / name) objs
+
+-- ============================================================================
+-- tzdata snapshot generation
+-- ============================================================================
+
+/-- Big-endian 32-bit field of a TZif header. -/
+def tzifField (b : ByteArray) (i : Nat) : Nat :=
+  b[i]!.toNat <<< 24 ||| b[i + 1]!.toNat <<< 16 ||| b[i + 2]!.toNat <<< 8 ||| b[i + 3]!.toNat
+
+/-- Drop the legacy 32-bit block of a v2+ TZif file by zeroing its header
+    counts; the 64-bit block and footer are kept as-is. -/
+def stripTzifV1 (b : ByteArray) : ByteArray :=
+  if b[4]!.toNat < 50 then b  -- version '1' or NUL
+  else
+    let body := tzifField b 32 * 5 + tzifField b 36 * 6 + tzifField b 40 +
+      tzifField b 28 * 8 + tzifField b 24 + tzifField b 20
+    b.extract 0 20 ++ ByteArray.mk (Array.replicate 24 0) ++ b.extract (44 + body) b.size
+
+/-- Generate `ffi/tzdata_snapshot.c` from a zoneinfo directory
+    (default /usr/share/zoneinfo). Identical zone files (links) share one
+    blob, and v2+ files keep only their 64-bit data.
+
+    Usage: `lake script run gen_tzdata [zoneinfo-dir]` -/
+script gen_tzdata (args) do
+  let dir : FilePath := args.head?.getD "/usr/share/zoneinfo"
+  let prefixLen := dir.toString.length + 1
+  let mut zones : Array (String × Nat) := #[]
+  let mut blobs : Array ByteArray := #[]
+  for path in ← dir.walkDir do
+    if ← path.isDir then continue
+    let rel := String.ofList (path.toString.toList.drop prefixLen)
+    if rel.startsWith "posix/" || rel.startsWith "right/" then continue
+    let bytes ← IO.FS.readBinFile path
+    -- Only TZif files ("TZif" magic)
+    unless bytes.size ≥ 44 && bytes[0]! == 84 && bytes[1]! == 90 && bytes[2]! == 105 &&
+        bytes[3]! == 102 do continue
+    let data := stripTzifV1 bytes
+    match blobs.findIdx? (fun b => b.size == data.size && b.data == data.data) with
+    | some i => zones := zones.push (rel, i)
+    | none =>
+      zones := zones.push (rel, blobs.size)
+      blobs := blobs.push data
+  let zones := zones.qsort (fun a b => a.1 < b.1)
+  let mut out := s!"/* Generated by `lake script run gen_tzdata` from {dir}. Do not edit. */\n\n"
+  out := out ++ "typedef struct {\n    const char* name;\n    const unsigned char* data;\n" ++
+    "    unsigned int size;\n} ChronosTzdataEntry;\n\n"
+  for i in [0:blobs.size] do
+    out := out ++ s!"static const unsigned char blob_{i}[] = \{"
+    let b := blobs[i]!
+    for j in [0:b.size] do
+      if j % 24 == 0 then out := out ++ "\n   "
+      out := out ++ s!" {b[j]!},"
+    out := out ++ "\n};\n"
+  out := out ++ "\nconst ChronosTzdataEntry chronos_tzdata_entries[] = {\n"
+  for (zone, i) in zones do
+    out := out ++ s!"    \{\"{zone}\", blob_{i}, {blobs[i]!.size}},\n"
+  out := out ++ s!"};\n\nconst unsigned int chronos_tzdata_entry_count = {zones.size};\n"
+  IO.FS.writeFile (("ffi" : FilePath) / "tzdata_snapshot.c") out
+  IO.println s!"wrote ffi/tzdata_snapshot.c: {zones.size} zones, {blobs.size} distinct"
+  return 0